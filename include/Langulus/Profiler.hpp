@@ -13,9 +13,16 @@
 #include <chrono>
 #include <string>
 #include <vector>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <limits>
 
 
 #if defined(LANGULUS_EXPORT_ALL) or defined(LANGULUS_EXPORT_PROFILER)
@@ -27,6 +34,10 @@
 /// Make the rest of the code aware, that Langulus::Profiler has been included
 #define LANGULUS_LIBRARY_PROFILER() 1
 
+#include "../../source/Timer.hpp"
+#include "../../source/Histogram.hpp"
+#include "../../source/Counters.hpp"
+
 
 namespace Langulus::Profiler
 {
@@ -42,34 +53,400 @@ namespace Langulus::Profiler
    long double RealMs(Time t) noexcept {
       return ::std::chrono::duration_cast<Nano>(t).count() / 1'000'000.0;
    }
-   
+
+
+   ///                                                                        
+   /// A measurement site, registered once per LANGULUS_PROFILE() call site   
+   /// Sites with the same name and build share a descriptor, so comparing    
+   /// descriptor pointers is the same as comparing names and builds          
+   ///                                                                        
+   struct Descriptor {
+      String   name;
+      String   file;
+      uint32_t line = 0;
+      BuildID  build = 0;
+      uint32_t id = 0;
+      String   category;
+
+      // Whether the site is measured at all, decided by the runtime    
+      // filters, and checked inline before anything else               
+      mutable ::std::atomic_bool enabled = true;
+
+      // Only every Nth entry of the site is measured, and counted N    
+      // times, can be changed at runtime - zero when the overhead      
+      // governor disabled the site                                     
+      mutable ::std::atomic<uint32_t> period = 1;
+   };
+
+
+   ///                                                                        
+   /// How measurements get compiled into results                             
+   ///                                                                        
+   enum class Mode {
+      // Starting and stopping a scope compiles it on the spot          
+      Immediate,
+      // Starting and stopping a scope only records an event in a       
+      // per-thread ring buffer, and a background aggregator thread     
+      // compiles the events into results                               
+      Deferred
+   };
+
+
+   ///                                                                        
+   /// What work counters count                                               
+   ///                                                                        
+   enum class Unit : uint32_t {
+      Items,
+      Bytes
+   };
+
+
+   ///                                                                        
+   /// A recorded scope begin (with descriptor) or end (without one)          
+   /// A begin's weight is how many entries it stands for, an end's weight    
+   /// is how many recursive entries were folded into the scope, and depth    
+   /// is the deepest of them. Work events carry the amount of work in place  
+   /// of the timestamp, and its unit in place of the weight, allocation and  
+   /// deallocation events carry the size in place of the timestamp, and      
+   /// counter events carry a counter's delta in place of the timestamp, and  
+   /// the counter in place of the weight. Frame events mark the end of a     
+   /// frame at their timestamp                                               
+   ///                                                                        
+   struct alignas(32) Event {
+      enum Kind : uint32_t {
+         Scope,
+         Work,
+         Allocation,
+         Deallocation,
+         Counter,
+         Frame
+      };
+
+      const Descriptor* descriptor;
+      Ticks    timestamp;
+      uint32_t weight;
+      uint32_t depth = 0;
+      Kind     kind = Scope;
+   };
+
+   // Events are half a cache line each, so that two fit in a line, and 
+   // none straddles two lines of the ring                              
+   static_assert(sizeof(Event) == 32, "Event must be half a cache line");
+
+
+   ///                                                                        
+   /// Work counted by a result's measurements in a single unit, and the      
+   /// throughput it was done with, in units per second                       
+   ///                                                                        
+   struct Throughput {
+      uint64_t amount = 0;
+      double   seconds = 0;
+      double   slowest = ::std::numeric_limits<double>::infinity();
+      double   fastest = 0;
+
+      LANGULUS_API(PROFILER) void Add(uint64_t amount, Time duration, uint32_t weight) noexcept;
+      LANGULUS_API(PROFILER) void Merge(const Throughput&) noexcept;
+
+      /// Get the throughput of all the counted work together                 
+      ///   @return units per second, or zero if nothing was counted          
+      double Average() const noexcept {
+         return seconds > 0 ? static_cast<double>(amount) / seconds : 0;
+      }
+   };
+
+
+   ///                                                                        
+   /// Heap allocations done by a result's measurements, and by the           
+   /// measurements nested in them - peak is the most bytes any single call   
+   /// had allocated and not yet freed at once                                
+   ///                                                                        
+   struct Allocations {
+      uint64_t count = 0;
+      uint64_t bytes = 0;
+      uint64_t peak = 0;
+
+      LANGULUS_API(PROFILER) void Add(const Allocations&, uint32_t weight) noexcept;
+      LANGULUS_API(PROFILER) void Merge(const Allocations&) noexcept;
+   };
+
+
+   /// Index of a result in a Database                                        
+   using Node = uint32_t;
+   constexpr Node NoNode = ~Node {0};
+
+
+   ///                                                                        
+   /// A call tree of compiled results                                        
+   /// Results are stored as parallel columns, indexed by node, so that       
+   /// reports, merges and any arithmetic over a statistic scan contiguous    
+   /// memory. Nodes always come after their parents, and are found by        
+   /// their parent and measurement site through a single open-addressing     
+   /// table. The descriptor id stands for both the name and the build        
+   /// fingerprint, because descriptors are interned per build                
+   ///                                                                        
+   struct Database {
+      // The tree structure - first child and next sibling link the     
+      // nodes in a tree that can be walked without any lookups         
+      ::std::vector<const Descriptor*> descriptor;
+      ::std::vector<Node> parent;
+      ::std::vector<Node> child;
+      ::std::vector<Node> sibling;
+
+      // The statistics, where mean and m2 are the running mean and the 
+      // sum of squared deviations from it, in nanoseconds, updated     
+      // with Welford's algorithm, and the histogram is kept for tail   
+      // latencies                                                      
+      ::std::vector<Time> min;
+      ::std::vector<Time> max;
+      ::std::vector<Time> total;
+      ::std::vector<long long> samples;
+      ::std::vector<long long> calls;
+      ::std::vector<double> mean;
+      ::std::vector<double> m2;
+      ::std::vector<Histogram> histogram;
+
+      // Work counted in each unit, by each result's measurements and   
+      // by the measurements nested in them                             
+      ::std::vector<Throughput> items;
+      ::std::vector<Throughput> bytes;
+
+      // Heap allocations of each result, if tracked                    
+      ::std::vector<Allocations> allocations;
+
+      // Recursive entries folded into each result, instead of being    
+      // measured on their own, and the deepest recursion among them    
+      ::std::vector<long long> recursions;
+      ::std::vector<uint32_t> deepest;
+
+      // Performance counters of each result, if counted, summed over   
+      // all its calls and including the ones nested in it              
+      ::std::vector<CounterValues> counters;
+
+      // The profiler's own cost included in each total, derived from   
+      // the statistics above by Compensate(), and never merged         
+      ::std::vector<Time> overhead;
+
+   private:
+      ::std::vector<Node> table;
+      Node first_root = NoNode;
+
+      LANGULUS_API(PROFILER) void Rehash();
+
+   public:
+      LANGULUS_API(PROFILER) auto Child(Node parent, const Descriptor&) -> Node;
+      LANGULUS_API(PROFILER) void Integrate(Node, Time, uint32_t weight = 1);
+      LANGULUS_API(PROFILER) void Fold(Node, uint32_t entries, uint32_t depth) noexcept;
+      LANGULUS_API(PROFILER) void Account(Node, Unit, uint64_t amount, Time, uint32_t weight) noexcept;
+      LANGULUS_API(PROFILER) void Merge(const Database&, ::std::vector<Node>& map);
+      LANGULUS_API(PROFILER) void Compensate(Time inner, Time outer);
+      LANGULUS_API(PROFILER) void CopyTree(const Database&);
+      LANGULUS_API(PROFILER) void Reset() noexcept;
+      LANGULUS_API(PROFILER) void Clear() noexcept;
+
+      LANGULUS_API(PROFILER) Time Average(Node) const noexcept;
+      LANGULUS_API(PROFILER) Time Deviation(Node) const noexcept;
+      LANGULUS_API(PROFILER) Real Variation(Node) const noexcept;
+      LANGULUS_API(PROFILER) Time Percentile(Node, double) const noexcept;
+      LANGULUS_API(PROFILER) void Dump(::std::ostream&, Node, const ::std::unordered_set<BuildID>& active) const;
+
+      /// Get the first of the top-level results                              
+      ///   @return the node, or NoNode if empty                              
+      Node Roots() const noexcept {
+         return first_root;
+      }
+
+      /// Get the number of results in the tree                               
+      ///   @return the number of nodes                                       
+      size_t Size() const noexcept {
+         return descriptor.size();
+      }
+
+      /// Check if the tree has no results                                    
+      ///   @return true if empty                                             
+      bool Empty() const noexcept {
+         return descriptor.empty();
+      }
+   };
+
+
+   ///                                                                        
+   /// A frame ended by FrameMark(), with the total time each result spent    
+   /// in it, the results nested in it included. Measurements that span       
+   /// several frames are split between them, at the frame marks, and only    
+   /// the measured entries of sampled sites are included                     
+   ///                                                                        
+   struct Frame {
+      Ticks start = 0;
+      Time  duration = Time::zero();
+      ::std::vector<::std::pair<Node, Time>> scopes;
+   };
+
 
    ///                                                                        
    /// The profiler state object, keeping track of running measurements       
    ///                                                                        
    struct State {
       struct Measurement;
-      struct Result;
       struct Stopper;
+      struct Thread;
 
-      using ResultPtr = ::std::unique_ptr<Result>;
-      using Database = ::std::unordered_map<String, ::std::unordered_map<Build, ResultPtr>>;
+      using Database = Profiler::Database;
+      using ThreadPtr = ::std::unique_ptr<Thread>;
 
    private:
-      Measurement* main = nullptr;
+      // Interned measurement sites, with stable addresses, and the     
+      // decoded builds behind each fingerprint, for reports            
+      ::std::mutex descriptors_guard;
+      ::std::deque<Descriptor> descriptors;
+      ::std::unordered_map<String, ::std::unordered_map<BuildID, const Descriptor*>> descriptor_index;
+      ::std::unordered_map<BuildID, Build> builds;
+
+      // Runtime filters, matched against site names or categories, in  
+      // the order they were added - the last one that matches a site   
+      // decides if it's enabled, and sites none match are enabled.     
+      // Guarded by the descriptors' guard                              
+      struct Filter {
+         String pattern;
+         bool   category;
+         bool   enable;
+      };
+
+      ::std::vector<Filter> filters;
+
+      // Every thread that ever measured something, registered on first 
+      // use - the lock is never taken on the measuring hot path. The   
+      // main thread is the one that constructed the state, during      
+      // static initialization, whenever it registers                   
+      ::std::mutex threads_guard;
+      ::std::vector<ThreadPtr> threads;
+      ::std::thread::id main_thread;
+
+      // Merged snapshot of all threads' results, rebuilt on each dump  
+      ::std::mutex dump_guard;
       Database results;
-      ::std::unordered_set<Build> active_builds;
+      ::std::unordered_set<BuildID> active_builds;
+
+      // Overhead governor, run on each dump - sites that have enough   
+      // samples, and whose instrumentation costs more than the budget  
+      // portion of their average duration, get sampled just enough to  
+      // fit in it, or disabled if even that isn't enough. The budget   
+      // is zero while the governor is off                              
+      struct Throttle {
+         const Descriptor* descriptor = nullptr;
+         double distortion = 0;
+      };
+
+      static constexpr long long GovernorMinSamples = 64;
+      static constexpr uint32_t  GovernorMaxPeriod = 1024;
+      ::std::atomic<Real> governor_budget = 0;
+      ::std::atomic<Time> governor_overhead = 0ns;
+      ::std::vector<Throttle> throttles;
+
+      // Frames of each thread that marks them, oldest first, copied on 
+      // each dump, with their results mapped into the merged snapshot  
+      struct Frames {
+         size_t thread;
+         bool   main;
+         size_t first;
+         ::std::vector<Frame> frames;
+      };
+
+      ::std::vector<Frames> frames;
+
+      // Timestamp source, declared before anything that reads it       
+      Timer timer;
+
+      // The cost of measuring an empty scope in each mode, calibrated  
+      // on startup - inner is the part that ends up in the scope's own 
+      // duration, outer is all of it, as seen by the scope's parent    
+      struct Overhead {
+         Ticks inner = 0;
+         Ticks outer = 0;
+      };
+
+      Overhead overhead[2];
 
       String output_file = "profiling.htm";
+      String folded_file;
+      bool   folded_per_build = false;
       Time output_interval = 1s;
-      TimePoint last_output_timestamp = Clock::now();
-
-      LANGULUS_API(PROFILER) void Compile(Measurement*);
-      LANGULUS_API(PROFILER) void DumpProfilerResults() const;
+      ::std::atomic<Ticks> last_output_timestamp = timer.Now();
+
+      // How many nested levels of a recursive site are measured as     
+      // results of their own, deeper ones are only counted             
+      ::std::atomic<uint32_t> recursion_levels = 1;
+
+      // Performance counters each thread opens when its outermost      
+      // scope starts, and the ones any thread failed to open           
+      ::std::atomic<CounterMask> counter_mask = 0;
+      ::std::atomic<CounterMask> counters_missing = 0;
+
+      // Deferred mode's background aggregator                          
+      ::std::atomic<Mode> mode = Mode::Immediate;
+      ::std::atomic_bool aggregating = false;
+      ::std::thread aggregator;
+
+      // Background writer, rendering the snapshots requested on every  
+      // output interval, so that measuring threads never render        
+      ::std::mutex writer_guard;
+      ::std::condition_variable writer_signal;
+      ::std::thread writer;
+      bool  write_requested = false;
+      bool  writer_stopping = false;
+      Ticks write_requested_at = 0;
+
+      // Binary trace, streamed by the writer in chunks, along with the 
+      // descriptors and builds it has already written                  
+      static constexpr Time TracePeriod = 100ms;
+      ::std::atomic_bool tracing = false;
+      ::std::mutex trace_guard;
+      ::std::ofstream trace_file;
+      size_t trace_descriptors = 0;
+      ::std::unordered_set<BuildID> trace_builds;
+      ::std::vector<uint8_t> trace_staging;
+
+      LANGULUS_API(PROFILER) auto AcquireThread() -> Thread&;
+      LANGULUS_API(PROFILER) auto Open(Thread&, const Descriptor&, uint32_t weight) -> Measurement*;
+      LANGULUS_API(PROFILER) bool Close(Thread&, Ticks, uint32_t folds, uint32_t deepest);
+      LANGULUS_API(PROFILER) bool Drain(Thread&);
+      LANGULUS_API(PROFILER) void EndFrame(Thread&, Ticks);
+      LANGULUS_API(PROFILER) void Record(Thread&, const Event&) noexcept;
+      LANGULUS_API(PROFILER) void Post(Thread&, const Event&) noexcept;
+      LANGULUS_API(PROFILER) void Aggregate();
+      LANGULUS_API(PROFILER) void Closed(Thread&, bool main_ended, Ticks now);
+      LANGULUS_API(PROFILER) void StartWriter();
+      LANGULUS_API(PROFILER) void RequestDump(Ticks);
+      LANGULUS_API(PROFILER) void Write();
+      LANGULUS_API(PROFILER) void FlushTrace();
+      LANGULUS_API(PROFILER) void Calibrate();
+      LANGULUS_API(PROFILER) bool Allows(const Descriptor&) const noexcept;
+      LANGULUS_API(PROFILER) void AddFilter(Filter&&);
+      LANGULUS_API(PROFILER) void Govern();
+      LANGULUS_API(PROFILER) void DumpProfilerResults(Ticks requested);
 
    public:
+      LANGULUS_API(PROFILER) State();
+      LANGULUS_API(PROFILER) ~State();
+
       LANGULUS_API(PROFILER) void Configure(String&&, Time interval) noexcept;
-      LANGULUS_API(PROFILER) auto Start(String&&, Build&&) -> Stopper;
+      LANGULUS_API(PROFILER) void Configure(Mode) noexcept;
+      LANGULUS_API(PROFILER) void ConfigureFolded(String&&, bool per_build = false) noexcept;
+      LANGULUS_API(PROFILER) void ConfigureGovernor(Real budget, Time overhead = Time::zero()) noexcept;
+      LANGULUS_API(PROFILER) void ConfigureRecursion(uint32_t levels) noexcept;
+      LANGULUS_API(PROFILER) void ConfigureCounters(CounterMask = HardwareCounters) noexcept;
+      LANGULUS_API(PROFILER) bool StartTrace(String&&);
+      LANGULUS_API(PROFILER) auto Register(String&&, String&&, uint32_t, const Build&, uint32_t period = 1, String&& category = {}) -> const Descriptor&;
+      LANGULUS_API(PROFILER) void Sample(const Descriptor&, uint32_t period) noexcept;
+      LANGULUS_API(PROFILER) void EnableCategory(String&& glob, bool enable = true);
+      LANGULUS_API(PROFILER) void EnableScopes(String&& glob, bool enable = true);
+      LANGULUS_API(PROFILER) void ResetFilters();
+      LANGULUS_API(PROFILER) auto Start(const Descriptor&, uint32_t weight) -> Stopper;
+      LANGULUS_API(PROFILER) void Stop(Thread&, const Descriptor&) noexcept;
+      LANGULUS_API(PROFILER) void Unfold(Thread&, const Descriptor&) noexcept;
+      LANGULUS_API(PROFILER) void Count(uint64_t amount, Unit) noexcept;
+      LANGULUS_API(PROFILER) void Allocated(size_t) noexcept;
+      LANGULUS_API(PROFILER) void Freed(size_t) noexcept;
+      LANGULUS_API(PROFILER) void FrameMark() noexcept;
       LANGULUS_API(PROFILER) void End();
    };
 
@@ -84,95 +461,322 @@ namespace Langulus::Profiler
    struct State::Measurement {
    protected:
       friend struct State;
-      String       name;
-      Build        build;
+      const Descriptor* descriptor;
       bool         ended = false;
-      TimePoint    start;
-      TimePoint    end;
+      Ticks        start;
+      Ticks        end;
       Measurement* parent = nullptr;
       Measurement* child = nullptr;
-      Result*      compiled = nullptr;
+      Node         compiled = NoNode;
+      uint32_t     weight = 1;
+
+      // Work counted in each Unit, the last one sizes the array        
+      static constexpr uint32_t UnitCount = static_cast<uint32_t>(Unit::Bytes) + 1;
+      uint64_t     work[UnitCount] {};
+      Allocations  allocations;
+      int64_t      live = 0;
+      CounterValues counters {};
+
+      /// Count an allocation done while the measurement was innermost        
+      ///   @param size - the size of the allocation in bytes                 
+      void Allocate(size_t size) noexcept {
+         ++allocations.count;
+         allocations.bytes += size;
+         live += static_cast<int64_t>(size);
+         if (live > 0 and static_cast<uint64_t>(live) > allocations.peak)
+            allocations.peak = static_cast<uint64_t>(live);
+      }
+
+      /// Count a deallocation done while the measurement was innermost -     
+      /// the memory may have been allocated anywhere                         
+      ///   @param size - the size of the allocation in bytes                 
+      void Free(size_t size) noexcept {
+         live -= static_cast<int64_t>(size);
+      }
 
    public:
       Measurement() = delete;
 
-      LANGULUS_API(PROFILER) Measurement(String&&, Build&&, Measurement*) noexcept;
-      LANGULUS_API(PROFILER) void Stop() noexcept;
+      LANGULUS_API(PROFILER) Measurement(const Descriptor&, Measurement*, Node, uint32_t weight) noexcept;
+   };
+
+
+   ///                                                                        
+   /// Per-thread profiler state                                              
+   /// Each thread keeps its own measurement chain and its own results, so    
+   /// measuring never touches memory shared with other threads. The guard    
+   /// protects everything below it, and is taken by whoever compiles the     
+   /// thread's measurements - the thread itself in immediate mode, or the    
+   /// aggregator in deferred mode - and by dumps                             
+   ///                                                                        
+   struct State::Thread {
+      ::std::thread::id id;
+      size_t       index = 0;
+
+      // Owned by the thread itself: number of open entries for each    
+      // descriptor id, so that recursion is detected without walking   
+      // the measurement stack, the recursive entries folded since the  
+      // innermost measured one, and the deepest of them, and the mode  
+      // that was latched when the outermost scope started, and whether 
+      // the thread is inside the profiler right now                    
+      ::std::vector<uint32_t> depth;
+      ::std::vector<uint32_t> folds;
+      ::std::vector<uint32_t> deepest;
+      size_t       open = 0;
+      bool         deferred = false;
+      bool         busy = false;
+
+      // Owned by the thread itself: its performance counters, the ones 
+      // that were requested when they were opened, and their values    
+      // at the start of each running measured scope                    
+      CounterGroup counters;
+      CounterMask  counters_requested = 0;
+      ::std::vector<CounterValues> counter_starts;
+
+      // Allocation events that didn't fit in the ring, because they    
+      // can't wait for it to be drained                                
+      ::std::atomic<size_t> lost_allocations = 0;
+
+      // Single-producer single-consumer ring of recorded events, the   
+      // thread produces, and consumers hold the guard while draining   
+      static constexpr size_t RingSize = 1 << 14;
+      ::std::unique_ptr<Event[]> ring;
+      alignas(64) ::std::atomic<size_t> ring_head = 0;
+      alignas(64) ::std::atomic<size_t> ring_tail = 0;
+
+      alignas(64) ::std::mutex guard;
+      Measurement* main = nullptr;
+      Measurement* top = nullptr;
+      Database     results;
+      ::std::unordered_set<BuildID> active_builds;
+
+      // Results compiled until the last dump, and the results swapped  
+      // out on it, kept with their statistics cleared, to be swapped   
+      // back in on the next one - only dumps touch them                
+      Database     results_dumped;
+      Database     results_spare;
+
+      // Frames marked by the thread: the total time of each result in  
+      // the running frame, the results that have any, and a ring of    
+      // the last FrameHistory frames that ended                        
+      static constexpr size_t FrameHistory = 256;
+      ::std::vector<Time> frame_total;
+      ::std::vector<Node> frame_nodes;
+      ::std::vector<Frame> frames;
+      size_t       frame_count = 0;
+      Ticks        frame_start = 0;
+      bool         framing = false;
+
+      // Encoded trace events waiting to be streamed, and the buffer    
+      // they get swapped with, which only the trace writer touches     
+      ::std::vector<uint8_t> trace;
+      ::std::vector<uint8_t> trace_spare;
+      Ticks        trace_last = 0;
+
+      // Measurement slots are allocated in blocks that live as long as 
+      // the thread state, and are recycled through a free list, so that
+      // starting and stopping scopes never hits the allocator          
+      union Slot {
+         Slot* next;
+         alignas(Measurement) ::std::byte storage[sizeof(Measurement)];
+      };
+
+      static constexpr size_t SlotsPerBlock = 64;
+      ::std::vector<::std::unique_ptr<Slot[]>> blocks;
+      Slot* free_slots = nullptr;
    };
 
 
+   LANGULUS_API(PROFILER) uint32_t& Skipping() noexcept;
+
+
    ///                                                                        
    /// Auto measurement stopper on scope end                                  
    ///                                                                        
    struct State::Stopper {
    private:
-      Measurement* measurement = nullptr;
+      Thread* thread = nullptr;
+      const Descriptor* descriptor = nullptr;
+      bool folded = false;
+      bool skipped = false;
 
    public:
+      /// Tag for the stopper of a skipped entry                              
+      struct Skip {};
+
       Stopper(const Stopper&) = delete;
 
       LANGULUS(ALWAYS_INLINED)
       Stopper() = default;
 
       LANGULUS(ALWAYS_INLINED)
-      Stopper(Measurement* m) noexcept
-         : measurement {m} {}
+      Stopper(Skip) noexcept
+         : skipped {true} {
+         ++Skipping();
+      }
+
+      LANGULUS(ALWAYS_INLINED)
+      Stopper(Thread& t, const Descriptor& d, bool f = false) noexcept
+         : thread {&t}
+         , descriptor {&d}
+         , folded {f} {}
 
       LANGULUS(ALWAYS_INLINED)
       Stopper(Stopper&& rhs) noexcept
-         : measurement {rhs.measurement} {
-         rhs.measurement = nullptr;
+         : thread {rhs.thread}
+         , descriptor {rhs.descriptor}
+         , folded {rhs.folded}
+         , skipped {rhs.skipped} {
+         rhs.descriptor = nullptr;
+         rhs.skipped = false;
       }
 
       LANGULUS(ALWAYS_INLINED)
       ~Stopper() {
-         if (measurement) {
-            measurement->Stop();
-            delete measurement;
-         }
+         if (skipped)
+            --Skipping();
+         if (not descriptor)
+            return;
+         if (folded)
+            Instance.Unfold(*thread, *descriptor);
+         else
+            Instance.Stop(*thread, *descriptor);
       }
    };
 
 
    ///                                                                        
-   /// A compiled result                                                      
+   /// Everything an HTML report is rendered from, shared by the runtime      
+   /// dumps and the offline trace converter                                  
    ///                                                                        
-   struct State::Result {
-      String name;
-      Build build;
-      Time min = Time::max();
-      Time max = Time::min();
-      Time average = 0ms;
-      mutable Time total = 0ms;
-      long long samples = 0;
-      Database children;
-
-      Result() = delete;
-      LANGULUS_API(PROFILER) Result(const Measurement&);
-      LANGULUS_API(PROFILER) void Integrate(const Measurement&);
-      LANGULUS_API(PROFILER) void Dump(::std::ofstream&, const Result* parent) const;
+   struct Report {
+      String heading;
+      String notes;
+      const Database& results;
+      const ::std::unordered_set<BuildID>& active_builds;
+      const ::std::unordered_map<BuildID, Build>& builds;
    };
 
+   LANGULUS_API(PROFILER) void WriteHtml(::std::ostream&, const Report&);
+   LANGULUS_API(PROFILER) void WriteFolded(::std::ostream&, const Database&, bool per_build = false);
+
 
-   /// Start doing a measurement                                              
+   /// Register a measurement site                                            
    ///   @param n - name of the measurement, usually the function name        
-   ///   @param build - the build identifier (should be inline-generated)     
-   ///   @return the auto-stopper                                             
+   ///   @param file - the file of the measurement site                       
+   ///   @param line - the line of the measurement site                       
+   ///   @param build - the build of the site's translation unit              
+   ///   @param period - measure only every Nth entry, one to measure all     
+   ///   @param category - the subsystem the site belongs to, for filtering   
+   ///   @return the interned descriptor                                      
    LANGULUS(ALWAYS_INLINED)
-   State::Stopper Start(String&& n, Build&& build) {
-      return Instance.Start(
+   const Descriptor& Register(String&& n, String&& file, uint32_t line, const Build& build, uint32_t period = 1, String&& category = {}) {
+      return Instance.Register(
          ::std::forward<String>(n),
-         ::std::forward<Build>(build)
+         ::std::forward<String>(file),
+         line, build, period,
+         ::std::forward<String>(category)
       );
    }
 
+   /// Start doing a measurement, unless the site is filtered out, or the     
+   /// entry is skipped by sampling, which costs only a relaxed load, a       
+   /// counter decrement, and a call for the thread's skipping depth          
+   ///   @param descriptor - the registered measurement site                  
+   ///   @param skip - the calling thread's entries of the site left to skip  
+   ///   @return the auto-stopper                                             
+   LANGULUS(ALWAYS_INLINED)
+   State::Stopper Start(const Descriptor& descriptor, uint32_t& skip) {
+      if (Skipping())
+         return State::Stopper {State::Stopper::Skip {}};
+      if (not descriptor.enabled.load(::std::memory_order_relaxed))
+         return {};
+      if (skip) {
+         --skip;
+         return State::Stopper {State::Stopper::Skip {}};
+      }
+
+      // The measured entry stands for the ones skipped until the next  
+      const auto weight = descriptor.period.load(::std::memory_order_relaxed);
+      if (not weight) {
+         // Disabled by the overhead governor                           
+         return {};
+      }
+      skip = weight - 1;
+      return Instance.Start(descriptor, weight);
+   }
+
+   /// Count work done by the calling thread's innermost running measurement, 
+   /// and by all the measurements it's nested in - ignored if nothing is     
+   /// being measured                                                         
+   ///   @param amount - how much work was done                               
+   ///   @param unit - what was counted                                       
+   LANGULUS(ALWAYS_INLINED)
+   void Count(uint64_t amount, Unit unit = Unit::Items) noexcept {
+      Instance.Count(amount, unit);
+   }
+
+   /// End the calling thread's current frame, and begin the next one         
+   LANGULUS(ALWAYS_INLINED)
+   void FrameMark() noexcept {
+      Instance.FrameMark();
+   }
+
 } // namespace Langulus::Profiler
 
 #undef LANGULUS_PROFILE
 
 /// Start scoped profiling                                                    
 /// Add one of these in the beginning of all functions you want to profile    
+/// The site is registered only once, on its first execution                  
 #define LANGULUS_PROFILE() \
-   const auto scoped_profiler____________ = ::Langulus::Profiler::Start(LANGULUS_FUNCTION(), ::Langulus::Profiler::Build {})
+   static const auto& scoped_profiler_site_______ = ::Langulus::Profiler::Register( \
+      LANGULUS_FUNCTION(), __FILE__, __LINE__, ::Langulus::Profiler::LocalBuild); \
+   static thread_local uint32_t scoped_profiler_skip_______ = 0; \
+   const auto scoped_profiler____________ = ::Langulus::Profiler::Start(scoped_profiler_site_______, scoped_profiler_skip_______)
+
+/// Start scoped profiling, measuring only every Nth entry                    
+/// Meant for functions so hot, that measuring every call would distort       
+/// them - skipped entries only decrement a per-thread counter of the site,   
+/// and skip everything nested in them, while everything nested in measured   
+/// entries is extrapolated along with them, and marked as estimated          
+#define LANGULUS_PROFILE_SAMPLED(N) \
+   static const auto& scoped_profiler_site_______ = ::Langulus::Profiler::Register( \
+      LANGULUS_FUNCTION(), __FILE__, __LINE__, ::Langulus::Profiler::LocalBuild, N); \
+   static thread_local uint32_t scoped_profiler_skip_______ = 0; \
+   const auto scoped_profiler____________ = ::Langulus::Profiler::Start(scoped_profiler_site_______, scoped_profiler_skip_______)
+
+/// Start scoped profiling of a site that belongs to a category, such as      
+/// "render" or "IO" - categories can be toggled at runtime, see              
+/// State::EnableCategory                                                     
+#define LANGULUS_PROFILE_CATEGORY(CATEGORY) \
+   static const auto& scoped_profiler_site_______ = ::Langulus::Profiler::Register( \
+      LANGULUS_FUNCTION(), __FILE__, __LINE__, ::Langulus::Profiler::LocalBuild, 1, CATEGORY); \
+   static thread_local uint32_t scoped_profiler_skip_______ = 0; \
+   const auto scoped_profiler____________ = ::Langulus::Profiler::Start(scoped_profiler_site_______, scoped_profiler_skip_______)
+
+/// Count items processed by the innermost profiled scope, such as entities   
+/// updated or triangles culled, to report its throughput                     
+#define LANGULUS_PROFILE_COUNT(AMOUNT) \
+   ::Langulus::Profiler::Count(AMOUNT, ::Langulus::Profiler::Unit::Items)
+
+/// Count bytes processed by the innermost profiled scope                     
+#define LANGULUS_PROFILE_BYTES(AMOUNT) \
+   ::Langulus::Profiler::Count(AMOUNT, ::Langulus::Profiler::Unit::Bytes)
+
+/// Mark the end of a frame on the calling thread, usually at the end of the  
+/// main loop's iteration                                                     
+#define LANGULUS_PROFILE_FRAME() \
+   ::Langulus::Profiler::FrameMark()
+
+#else
+
+/// Sampled and categorized profiling, work counters, and frame marks compile 
+/// to nothing when profiling is disabled                                     
+#define LANGULUS_PROFILE_SAMPLED(N)
+#define LANGULUS_PROFILE_CATEGORY(CATEGORY)
+#define LANGULUS_PROFILE_COUNT(AMOUNT)
+#define LANGULUS_PROFILE_BYTES(AMOUNT)
+#define LANGULUS_PROFILE_FRAME()
 
 #endif
\ No newline at end of file
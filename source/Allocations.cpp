@@ -0,0 +1,128 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#include <Langulus/Profiler.hpp>
+#include <cstdlib>
+#include <new>
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be built at all if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+#if LANGULUS_FEATURE(NEWDELETE)
+   #error Langulus already replaces new and delete - report its allocations through State::Allocated and State::Freed instead
+#endif
+
+///                                                                           
+/// Replacements of the global new and delete, built only with the            
+/// LANGULUS_PROFILER_ALLOCATIONS option, that report every allocation to     
+/// the profiler. Each allocation is prefixed with its size, padded so that   
+/// the default new alignment is kept. Overaligned new and delete are left    
+/// to the standard library, and aren't tracked                               
+///                                                                           
+
+namespace
+{
+
+   constexpr size_t Header = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+   static_assert(Header >= sizeof(size_t));
+
+   /// Allocate memory, prefixed with its size                                
+   ///   @param size - the number of bytes requested                          
+   ///   @return the memory, or nullptr if out of memory                      
+   void* Allocate(size_t size) noexcept {
+      const auto base = static_cast<size_t*>(::std::malloc(size + Header));
+      if (not base)
+         return nullptr;
+
+      *base = size;
+      ::Langulus::Profiler::Instance.Allocated(size);
+      return reinterpret_cast<::std::byte*>(base) + Header;
+   }
+
+   /// Allocate memory the way operator new does - calling the new            
+   /// handler until it succeeds, or throwing if there's no handler           
+   ///   @param size - the number of bytes requested                          
+   ///   @return the memory                                                   
+   void* AllocateOrThrow(size_t size) {
+      if (not size)
+         size = 1;
+
+      while (true) {
+         if (const auto memory = Allocate(size))
+            return memory;
+
+         const auto handler = ::std::get_new_handler();
+         if (not handler)
+            throw ::std::bad_alloc {};
+         handler();
+      }
+   }
+
+   /// Free memory that was allocated by Allocate()                           
+   ///   @param memory - the memory to free, can be nullptr                   
+   void Free(void* memory) noexcept {
+      if (not memory)
+         return;
+
+      const auto base = static_cast<::std::byte*>(memory) - Header;
+      ::Langulus::Profiler::Instance.Freed(*reinterpret_cast<size_t*>(base));
+      ::std::free(base);
+   }
+
+} // namespace
+
+
+void* operator new(size_t size) {
+   return AllocateOrThrow(size);
+}
+
+void* operator new[](size_t size) {
+   return AllocateOrThrow(size);
+}
+
+void* operator new(size_t size, const ::std::nothrow_t&) noexcept {
+   try {
+      return AllocateOrThrow(size);
+   }
+   catch (...) {
+      return nullptr;
+   }
+}
+
+void* operator new[](size_t size, const ::std::nothrow_t&) noexcept {
+   try {
+      return AllocateOrThrow(size);
+   }
+   catch (...) {
+      return nullptr;
+   }
+}
+
+void operator delete(void* memory) noexcept {
+   Free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+   Free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+   Free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+   Free(memory);
+}
+
+void operator delete(void* memory, const ::std::nothrow_t&) noexcept {
+   Free(memory);
+}
+
+void operator delete[](void* memory, const ::std::nothrow_t&) noexcept {
+   Free(memory);
+}
@@ -0,0 +1,177 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#include <Langulus/Profiler.hpp>
+#include <fmt/format.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be built at all if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+using namespace ::Langulus;
+using namespace ::Langulus::Profiler;
+
+/// Allocations are counted here, unless the profiler already replaces the    
+/// global new and delete to track them itself                                
+#if defined(LANGULUS_PROFILER_ALLOCATIONS)
+   #define LANGULUS_PROFILER_BENCHMARK_ALLOCATIONS() 0
+#else
+   #define LANGULUS_PROFILER_BENCHMARK_ALLOCATIONS() 1
+#endif
+
+#if LANGULUS_PROFILER_BENCHMARK_ALLOCATIONS()
+   /// Heap allocations done by the whole process, the profiler included      
+   ::std::atomic<size_t> HeapAllocations = 0;
+
+   void* operator new(::std::size_t size) {
+      HeapAllocations.fetch_add(1, ::std::memory_order_relaxed);
+      if (auto p = ::std::malloc(size ? size : 1))
+         return p;
+      throw ::std::bad_alloc {};
+   }
+
+   void operator delete(void* p) noexcept {
+      ::std::free(p);
+   }
+
+   void operator delete(void* p, ::std::size_t) noexcept {
+      ::std::free(p);
+   }
+#endif
+
+namespace
+{
+
+   /// Entries measured by each timed run, after a run that warms up the      
+   /// caches, the measurement slots and the thread state                     
+   constexpr size_t Entries = 1'000'000;
+
+   /// Get the number of heap allocations done so far                         
+   ///   @return the number, or zero if they aren't counted                   
+   size_t AllocationsSoFar() noexcept {
+      #if LANGULUS_PROFILER_BENCHMARK_ALLOCATIONS()
+         return HeapAllocations.load(::std::memory_order_relaxed);
+      #else
+         return 0;
+      #endif
+   }
+
+   /// An empty function without instrumentation, as the baseline             
+   void Bare() {
+      ::std::atomic_signal_fence(::std::memory_order_seq_cst);
+   }
+
+   /// An empty function with a measured scope                                
+   void Empty() {
+      LANGULUS_PROFILE();
+      ::std::atomic_signal_fence(::std::memory_order_seq_cst);
+   }
+
+   /// An empty function with a scope measured on every 1024th entry only     
+   void Sampled() {
+      LANGULUS_PROFILE_SAMPLED(1024);
+      ::std::atomic_signal_fence(::std::memory_order_seq_cst);
+   }
+
+   /// The cost of a run of entries                                           
+   struct Cost {
+      double nanoseconds;
+      double allocations;
+   };
+
+   /// Time a function called Entries times, after calling it as many times   
+   /// to warm up - it's called through a volatile pointer, so that it can't  
+   /// be inlined into the loop                                               
+   ///   @param function - the function to call                               
+   ///   @return the cost per call                                            
+   Cost Measure(void (*function)()) {
+      void (* volatile f)() = function;
+      for (size_t i = 0; i < Entries; ++i)
+         f();
+
+      const auto allocations = AllocationsSoFar();
+      const auto start = Clock::now();
+      for (size_t i = 0; i < Entries; ++i)
+         f();
+      const auto elapsed = Clock::now() - start;
+
+      return {
+         ::std::chrono::duration<double, ::std::nano>(elapsed).count() / Entries,
+         static_cast<double>(AllocationsSoFar() - allocations) / Entries
+      };
+   }
+
+   /// Open a measured scope at each level down to the requested depth, and   
+   /// measure empty scopes at the bottom                                     
+   ///   @param depth - levels left to open                                   
+   ///   @return the cost of an empty scope at that depth                     
+   Cost Nest(size_t depth) {
+      LANGULUS_PROFILE();
+      if (depth > 1)
+         return Nest(depth - 1);
+      return Measure(Empty);
+   }
+
+   /// Report the cost of an empty scope in a mode, and at growing depths     
+   /// Each mode runs on its own thread, whose outermost scope latches the    
+   /// mode, and whose master measurement isn't the main thread's, so         
+   /// ending it doesn't end the profiler                                     
+   ///   @param mode - the recording mode                                     
+   ///   @param name - the mode's name                                        
+   ///   @param bare - the cost of a call without instrumentation             
+   void Run(Mode mode, const char* name, const Cost& bare) {
+      Instance.Configure(mode);
+      ::std::thread {[&] {
+         LANGULUS_PROFILE();
+
+         const auto empty = Measure(Empty);
+         Logger::Info(fmt::format(
+            "{:>9}: {:6.1f} ns per empty scope ({:+.1f} ns over a bare call), {:.3f} allocations",
+            name, empty.nanoseconds, empty.nanoseconds - bare.nanoseconds, empty.allocations
+         ));
+
+         // Skipped entries of sampled scopes don't start a measurement 
+         const auto sampled = Measure(Sampled);
+         Logger::Info(fmt::format(
+            "{:>9}  {:6.1f} ns per scope sampled 1 in 1024, {:.3f} allocations",
+            "", sampled.nanoseconds, sampled.allocations
+         ));
+
+         // Entering a scope must cost the same at any depth            
+         for (size_t depth : {1, 4, 16, 64, 256}) {
+            const auto nested = Nest(depth);
+            Logger::Info(fmt::format(
+               "{:>9}  {:6.1f} ns at depth {}, {:.3f} allocations",
+               "", nested.nanoseconds, depth, nested.allocations
+            ));
+         }
+      }}.join();
+   }
+
+} // namespace
+
+
+/// Measure the profiler's cost per empty scope in both recording modes       
+///   @return zero                                                            
+int main() {
+   // Nothing is written out - the main thread never opens a scope      
+   Instance.Configure("", Time::zero());
+   Instance.ConfigureRecursion(1024);
+
+   const auto bare = Measure(Bare);
+   Logger::Info(fmt::format("{:>9}: {:6.1f} ns per bare call", "baseline", bare.nanoseconds));
+   #if not LANGULUS_PROFILER_BENCHMARK_ALLOCATIONS()
+      Logger::Info("Allocations aren't counted, because the profiler tracks them itself");
+   #endif
+
+   Run(Mode::Immediate, "immediate", bare);
+   Run(Mode::Deferred, "deferred", bare);
+   return 0;
+}
@@ -15,7 +15,10 @@
 
 namespace Langulus::Profiler
 {
-   
+
+   /// A 64-bit fingerprint of a build configuration                          
+   using BuildID = ::std::uint64_t;
+
    ///                                                                        
    /// A build configuration                                                  
    ///                                                                        
@@ -81,12 +84,35 @@ namespace Langulus::Profiler
          Counter
       };
 
+      static constexpr const char* Names[Property::Counter] {
+         "Safe", "Test", "Benchmark", "Paranoia", "Debug",
+
+         "ManagedReflection", "ManagedMemory", "MemoryStatistics",
+         "OverrideNewDelete", "Unicode", "Compression", "Encryption",
+
+         "CompilerGCC", "CompilerMSVC", "CompilerClang", "CompilerWASM",
+         "CompilerMinGW",
+
+         "OSWindows", "OSLinux", "OSAndroid", "OSMacos", "OSUnix",
+         "OSFreeBSD",
+
+         "LoggerFatalError", "LoggerError", "LoggerWarning",
+         "LoggerVerbose", "LoggerInfo", "LoggerMessage", "LoggerSpecial",
+         "LoggerFlow", "LoggerInput", "LoggerNetwork", "LoggerOS",
+         "LoggerPrompt",
+
+         "SIMD", "AVX512BW", "AVX512CD", "AVX512DQ", "AVX512F", "AVX512VL",
+         "AVX512", "AVX2", "AVX", "SSE4_2", "SSE4_1", "SSSE3", "SSE3",
+         "SSE2", "SSE"
+      };
+
       ::std::bitset<Property::Counter> properties = 0;
       uint8_t bitness = 0;
       uint8_t alignment = 0;
       uint8_t endianness = 0;
 
       constexpr Build() noexcept;
+      constexpr BuildID ID() const noexcept;
 
       constexpr bool operator == (const Build& rhs) const noexcept {
          return properties == rhs.properties
@@ -107,8 +133,7 @@ namespace std
       using B = ::Langulus::Profiler::Build;
 
       size_t operator()(const B& what) const noexcept {
-         size_t ph = hash<decltype(B::properties)> {}(what.properties);
-         return ph ^ ((what.bitness << 24) | (what.alignment << 16) | (what.endianness << 8));
+         return static_cast<size_t>(what.ID());
       }
    };
 
@@ -215,4 +240,28 @@ namespace Langulus::Profiler
          endianness = 0;
    }
 
+   /// Get the 64-bit fingerprint of the build configuration                  
+   /// All properties and the layout are mixed through the splitmix64         
+   /// finalizer, so that similar builds still get well-distributed hashes    
+   ///   @return the fingerprint                                              
+   constexpr BuildID Build::ID() const noexcept {
+      constexpr auto mix = [](BuildID x) constexpr noexcept {
+         x ^= x >> 30;
+         x *= 0xBF58476D1CE4E5B9ull;
+         x ^= x >> 27;
+         x *= 0x94D049BB133111EBull;
+         x ^= x >> 31;
+         return x;
+      };
+
+      const BuildID layout = (BuildID {bitness} << 16)
+                           | (BuildID {alignment} << 8)
+                           | BuildID {endianness};
+      return mix(mix(properties.to_ullong()) ^ layout);
+   }
+
+   /// Build of the translation unit that includes this header, generated     
+   /// at compile time, so that profiled call sites never construct it        
+   static constexpr Build LocalBuild {};
+
 } // namespace Langulus::Profiler
\ No newline at end of file
@@ -0,0 +1,347 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#include "Trace.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be built at all if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+using namespace ::Langulus;
+using namespace ::Langulus::Profiler;
+
+
+namespace
+{
+
+   ///                                                                        
+   /// Results compiled from a loaded trace                                   
+   ///                                                                        
+   struct Compiled {
+      Database results;
+      ::std::unordered_set<BuildID> active_builds;
+      Ticks first = ~Ticks {0};
+      Ticks last = 0;
+   };
+
+   /// Replay the events of all threads, compiling them into results the      
+   /// same way the profiler does at runtime                                  
+   ///   @param trace - the loaded trace                                      
+   ///   @return the compiled results                                         
+   Compiled Compile(const Trace::File& trace) {
+      Compiled out;
+      struct Scope {
+         Node     node;
+         Ticks    start;
+         uint32_t weight;
+      };
+
+      ::std::vector<Scope> stack;
+      for (auto& events : trace.threads) {
+         stack.clear();
+         for (auto& e : events) {
+            out.first = ::std::min(out.first, e.timestamp);
+            out.last = ::std::max(out.last, e.timestamp);
+
+            if (e.descriptor != Trace::Entry::NoDescriptor) {
+               const auto& d = trace.descriptors[e.descriptor];
+               const auto parent = stack.empty() ? NoNode : stack.back().node;
+               stack.push_back({out.results.Child(parent, d), e.timestamp, e.weight});
+            }
+            else if (not stack.empty()) {
+               // Ends without a begin belong to scopes that were       
+               // already running when the trace was started, and are   
+               // skipped                                               
+               auto [node, start, weight] = stack.back();
+               stack.pop_back();
+               out.results.Integrate(node, trace.ToTime(e.timestamp - start), weight);
+               out.active_builds.insert(out.results.descriptor[node]->build);
+            }
+         }
+
+         // Scopes that were still running when the trace was cut       
+         // contribute the time elapsed until the thread's last event   
+         if (not events.empty()) {
+            for (auto [node, start, weight] : stack)
+               out.results.total[node] += trace.ToTime(events.back().timestamp - start);
+         }
+      }
+      return out;
+   }
+
+   /// Quote and escape a string as a JSON literal                            
+   ///   @param s - the string to escape                                      
+   ///   @return the JSON literal                                             
+   String JsonString(const String& s) {
+      String out = "\"";
+      for (const char c : s) {
+         switch (c) {
+         case '"':  out += "\\\""; break;
+         case '\\': out += "\\\\"; break;
+         case '\n': out += "\\n";  break;
+         case '\t': out += "\\t";  break;
+         default:
+            if (static_cast<unsigned char>(c) < 0x20)
+               out += fmt::format("\\u{:04x}", c);
+            else
+               out += c;
+         }
+      }
+      return out += '"';
+   }
+
+   /// Write a level of the result tree as a JSON array                       
+   ///   @param out - the stream to write to                                  
+   ///   @param results - the tree to write                                   
+   ///   @param level - the first result on the level                         
+   void WriteJson(::std::ostream& out, const Database& results, Node level) {
+      out << '[';
+      for (auto n = level; n != NoNode; n = results.sibling[n]) {
+         if (n != level)
+            out << ',';
+
+         const auto d = results.descriptor[n];
+         out << "{\"name\":" << JsonString(d->name)
+             << ",\"file\":" << JsonString(d->file)
+             << ",\"line\":" << d->line
+             << ",\"build\":\"" << fmt::format("{:016X}", d->build) << '"'
+             << ",\"samples\":" << results.samples[n]
+             << ",\"calls\":" << results.calls[n]
+             << ",\"estimated\":" << (results.calls[n] != results.samples[n] ? "true" : "false")
+             << ",\"total_ms\":" << RealMs(results.total[n]);
+         if (results.samples[n]) {
+            out << ",\"min_ms\":" << RealMs(results.min[n])
+                << ",\"avg_ms\":" << RealMs(results.Average(n))
+                << ",\"max_ms\":" << RealMs(results.max[n])
+                << ",\"stddev_ms\":" << RealMs(results.Deviation(n))
+                << ",\"cv\":" << results.Variation(n)
+                << ",\"p50_ms\":" << RealMs(results.Percentile(n, 0.5))
+                << ",\"p90_ms\":" << RealMs(results.Percentile(n, 0.9))
+                << ",\"p99_ms\":" << RealMs(results.Percentile(n, 0.99))
+                << ",\"p999_ms\":" << RealMs(results.Percentile(n, 0.999));
+         }
+         out << ",\"children\":";
+         WriteJson(out, results, results.child[n]);
+         out << '}';
+      }
+      out << ']';
+   }
+
+   /// Stream a trace into Chrome Trace Event Format, that can be opened in   
+   /// Perfetto or chrome://tracing - each thread gets its own track, and     
+   /// scopes become begin/end pairs. Events are converted one chunk at a     
+   /// time, so memory use doesn't depend on the size of the trace            
+   ///   @param input - the trace file                                        
+   ///   @param output - the JSON file to write                               
+   ///   @return true on success                                              
+   bool ExportChrome(const String& input, const String& output) {
+      Trace::Reader reader;
+      if (not reader.Open(input))
+         return false;
+
+      ::std::ofstream out {output, ::std::ios::out | ::std::ios::trunc};
+      if (not out.is_open()) {
+         Logger::Error("Can't open output file: ", output);
+         return false;
+      }
+
+      // The begin event's fields, escaped once per descriptor          
+      ::std::vector<String> fields;
+      const auto describe = [&](uint32_t id) -> const String& {
+         while (fields.size() <= id) {
+            const auto& d = reader.descriptors[fields.size()];
+            fields.push_back(fmt::format(
+               "\"name\":{},\"cat\":\"{:016X}\",\"args\":{{\"build\":\"{:016X}\",\"file\":{},\"line\":{}}}",
+               JsonString(d.name), d.build, d.build, JsonString(d.file), d.line
+            ));
+         }
+         return fields[id];
+      };
+
+      // Timestamps are written in microseconds since the first event   
+      // Scopes that were open when the trace started have no begin, so 
+      // their ends are skipped, and scopes still open when it ended    
+      // are closed at the last event of their thread                   
+      struct Track {
+         bool   named = false;
+         size_t open = 0;
+         Ticks  last = 0;
+      };
+
+      ::std::vector<Track> tracks;
+      bool has_origin = false;
+      Ticks origin = 0;
+      const auto stamp = [&](Ticks t) {
+         const auto ticks = static_cast<int64_t>(t - origin);
+         return static_cast<double>(ticks) * reader.ns_per_tick / 1000.0;
+      };
+
+      out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+      out << R"({"ph":"M","name":"process_name","pid":0,"args":{"name":"Langulus"}})";
+
+      size_t thread;
+      ::std::vector<Trace::Entry> events;
+      while (reader.Next(thread, events)) {
+         if (thread >= tracks.size())
+            tracks.resize(thread + 1);
+
+         auto& track = tracks[thread];
+         if (not track.named) {
+            out << fmt::format(
+               ",\n{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+               thread, thread == reader.main_thread ? String {"Main thread"} : fmt::format("Thread {}", thread)
+            );
+            track.named = true;
+         }
+
+         for (auto& e : events) {
+            if (not has_origin) {
+               origin = e.timestamp;
+               has_origin = true;
+            }
+
+            track.last = e.timestamp;
+            if (e.descriptor != Trace::Entry::NoDescriptor) {
+               ++track.open;
+               out << fmt::format(
+                  ",\n{{\"ph\":\"B\",\"ts\":{:.3f},\"pid\":0,\"tid\":{},{}}}",
+                  stamp(e.timestamp), thread, describe(e.descriptor)
+               );
+            }
+            else if (track.open) {
+               --track.open;
+               out << fmt::format(
+                  ",\n{{\"ph\":\"E\",\"ts\":{:.3f},\"pid\":0,\"tid\":{}}}",
+                  stamp(e.timestamp), thread
+               );
+            }
+         }
+      }
+
+      for (size_t t = 0; t < tracks.size(); ++t) {
+         for (; tracks[t].open; --tracks[t].open) {
+            out << fmt::format(
+               ",\n{{\"ph\":\"E\",\"ts\":{:.3f},\"pid\":0,\"tid\":{}}}",
+               stamp(tracks[t].last), t
+            );
+         }
+      }
+
+      out << "\n]}\n";
+      if (not out) {
+         Logger::Error("Failed writing output file: ", output);
+         return false;
+      }
+      return true;
+   }
+
+   /// Write a string to a file, reporting failure                            
+   ///   @param path - the file to overwrite                                  
+   ///   @param contents - what to write                                      
+   ///   @return true on success                                              
+   bool Save(const String& path, ::std::string_view contents) {
+      ::std::ofstream out {path, ::std::ios::out | ::std::ios::trunc};
+      if (not out.is_open()) {
+         Logger::Error("Can't open output file: ", path);
+         return false;
+      }
+      out << contents;
+      return true;
+   }
+
+   /// Print how the converter is used                                        
+   void Usage() {
+      Logger::Info("Usage: LangulusProfilerConverter <trace> [--html <file>] [--json <file>] [--chrome <file>] [--folded <file>] [--folded-builds <file>]");
+      Logger::Info("Converts a binary profiler trace to reports - by default, to <trace>.htm");
+   }
+
+} // namespace
+
+
+/// Convert a binary trace to the requested views                             
+///   @return zero on success                                                 
+int main(int argc, char** argv) {
+   if (argc < 2) {
+      Usage();
+      return 1;
+   }
+
+   const String input = argv[1];
+   String html, json, chrome, folded;
+   bool per_build = false;
+   for (int i = 2; i < argc; ++i) {
+      const ::std::string_view arg = argv[i];
+      if (i + 1 < argc and arg == "--html")
+         html = argv[++i];
+      else if (i + 1 < argc and arg == "--json")
+         json = argv[++i];
+      else if (i + 1 < argc and arg == "--chrome")
+         chrome = argv[++i];
+      else if (i + 1 < argc and (arg == "--folded" or arg == "--folded-builds")) {
+         folded = argv[++i];
+         per_build = arg == "--folded-builds";
+      }
+      else {
+         Usage();
+         return 1;
+      }
+   }
+
+   if (html.empty() and json.empty() and chrome.empty() and folded.empty())
+      html = input + ".htm";
+
+   // The timeline is streamed, without loading the whole trace         
+   bool success = true;
+   if (not chrome.empty())
+      success &= ExportChrome(input, chrome);
+   if (html.empty() and json.empty() and folded.empty())
+      return success ? 0 : 1;
+
+   Trace::File trace;
+   if (not trace.Load(input))
+      return 1;
+
+   const auto compiled = Compile(trace);
+
+   if (not html.empty()) {
+      const auto span = compiled.last > compiled.first
+         ? trace.ToTime(compiled.last - compiled.first) : Time::zero();
+      const auto heading = fmt::format(
+         "Performance results from trace {} ({} threads)",
+         input, trace.threads.size()
+      );
+
+      ::std::ostringstream notes;
+      notes << "<div>- trace spans " << RealMs(span) << " ms, "
+            << trace.descriptors.size() << " measurement sites</div>\n";
+
+      ::std::ostringstream page;
+      WriteHtml(page, {
+         heading, notes.str(), compiled.results,
+         compiled.active_builds, trace.builds
+      });
+      success &= Save(html, page.view());
+   }
+
+   if (not json.empty()) {
+      ::std::ostringstream page;
+      WriteJson(page, compiled.results, compiled.results.Roots());
+      success &= Save(json, page.view());
+   }
+
+   if (not folded.empty()) {
+      ::std::ostringstream page;
+      WriteFolded(page, compiled.results, per_build);
+      success &= Save(folded, page.view());
+   }
+
+   return success ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#include <Langulus/Profiler.hpp>
+
+#if LANGULUS_PROFILER_HAS_PERF()
+   #include <linux/perf_event.h>
+   #include <sys/ioctl.h>
+   #include <sys/mman.h>
+   #include <sys/syscall.h>
+   #include <unistd.h>
+
+   #if defined(__x86_64__) or defined(__i386__)
+      #include <x86intrin.h>
+      #define LANGULUS_PROFILER_HAS_RDPMC() 1
+   #else
+      #define LANGULUS_PROFILER_HAS_RDPMC() 0
+   #endif
+#endif
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be built at all if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+
+namespace Langulus::Profiler
+{
+
+   static_assert(::std::size(CounterNames) == static_cast<size_t>(Counter::Count),
+      "Each counter must have a name");
+
+   #if LANGULUS_PROFILER_HAS_PERF()
+   namespace
+   {
+      /// How each counter is requested from perf_event_open                  
+      struct Event {
+         uint32_t type;
+         uint64_t config;
+      };
+
+      constexpr Event Events[] {
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+         {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+         {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+      };
+
+      /// Open a counter of the calling thread, on any CPU                    
+      ///   @param event - the counter to open                                
+      ///   @param group - the group leader, or -1 to lead a new group        
+      ///   @param user_only - whether to count only in user space            
+      ///   @return the file descriptor, or -1 on failure                     
+      int OpenEvent(const Event& event, int group, bool user_only) noexcept {
+         perf_event_attr attr {};
+         attr.size = sizeof(attr);
+         attr.type = event.type;
+         attr.config = event.config;
+         attr.disabled = group == -1;
+         attr.exclude_kernel = user_only;
+         attr.exclude_hv = 1;
+         attr.read_format = PERF_FORMAT_GROUP;
+         return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+      }
+
+      /// Read a counter from its mapped page, in user space                  
+      /// Follows the protocol documented in linux/perf_event.h               
+      ///   @param page - the mapped page of the counter                      
+      ///   @return the value of the counter                                  
+      uint64_t ReadMapped(const perf_event_mmap_page* page) noexcept {
+         uint32_t seq;
+         uint64_t count;
+         do {
+            seq = page->lock;
+            ::std::atomic_signal_fence(::std::memory_order_seq_cst);
+            count = static_cast<uint64_t>(page->offset);
+            #if LANGULUS_PROFILER_HAS_RDPMC()
+               if (page->cap_user_rdpmc and page->index) {
+                  const auto width = page->pmc_width;
+                  auto pmc = static_cast<int64_t>(__rdpmc(static_cast<int>(page->index - 1)));
+                  pmc = static_cast<int64_t>(static_cast<uint64_t>(pmc) << (64 - width)) >> (64 - width);
+                  count += static_cast<uint64_t>(pmc);
+               }
+            #endif
+            ::std::atomic_signal_fence(::std::memory_order_seq_cst);
+         } while (page->lock != seq);
+         return count;
+      }
+   }
+   #endif
+
+   /// Close all counters                                                     
+   CounterGroup::~CounterGroup() {
+      Close();
+   }
+
+   /// Open the requested counters for the calling thread, and start them     
+   /// Hardware and software counters are opened as separate groups, so that  
+   /// the hardware ones can be read in user space regardless of the          
+   /// software ones. The first counter of each kind that can be opened       
+   /// leads its group, and the rest join it, or are left out if they can't   
+   /// Software counters are counted in kernel space too, where the kernel    
+   /// allows it                                                              
+   ///   @param request - the counters to open                                
+   ///   @return the counters that were opened                                
+   CounterMask CounterGroup::Open(CounterMask request) noexcept {
+      Close();
+
+      #if LANGULUS_PROFILER_HAS_PERF()
+         for (size_t c = 0; c < Count; ++c) {
+            if (not (request & Mask(static_cast<Counter>(c))))
+               continue;
+
+            const auto& event = Events[c];
+            const bool is_software = event.type == PERF_TYPE_SOFTWARE;
+            auto& group = is_software ? software : hardware;
+            auto fd = OpenEvent(event, group.leader, not is_software);
+            if (fd == -1 and is_software)
+               fd = OpenEvent(event, group.leader, true);
+            if (fd == -1)
+               continue;
+
+            if (group.leader == -1)
+               group.leader = fd;
+            fds[c] = fd;
+            group.order[group.size++] = static_cast<uint8_t>(c);
+            opened |= Mask(static_cast<Counter>(c));
+         }
+
+         // Map the hardware counters' pages, to read them with rdpmc,  
+         // if the kernel allows it for all of them                     
+         #if LANGULUS_PROFILER_HAS_RDPMC()
+            if (hardware.size) {
+               page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+               mapped = true;
+               for (size_t i = 0; i < hardware.size and mapped; ++i) {
+                  const auto c = hardware.order[i];
+                  const auto page = ::mmap(nullptr, page_size, PROT_READ, MAP_SHARED, fds[c], 0);
+                  if (page == MAP_FAILED) {
+                     mapped = false;
+                     break;
+                  }
+
+                  pages[c] = page;
+                  mapped = static_cast<const perf_event_mmap_page*>(page)->cap_user_rdpmc;
+               }
+            }
+         #endif
+
+         for (auto leader : {hardware.leader, software.leader}) {
+            if (leader == -1)
+               continue;
+            ::ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+         }
+      #endif
+      return opened;
+   }
+
+   /// Close all counters                                                     
+   void CounterGroup::Close() noexcept {
+      #if LANGULUS_PROFILER_HAS_PERF()
+         for (size_t c = 0; c < Count; ++c) {
+            if (pages[c])
+               ::munmap(pages[c], page_size);
+            if (fds[c] != -1)
+               ::close(fds[c]);
+         }
+      #endif
+
+      fds.fill(-1);
+      pages.fill(nullptr);
+      hardware = {};
+      software = {};
+      opened = 0;
+      mapped = false;
+   }
+
+   /// Read all counters - the ones that aren't opened are zero               
+   ///   @param values - [out] the values                                     
+   void CounterGroup::Read(CounterValues& values) const noexcept {
+      values.fill(0);
+
+      #if LANGULUS_PROFILER_HAS_PERF()
+         if (mapped) {
+            for (size_t i = 0; i < hardware.size; ++i) {
+               const auto c = hardware.order[i];
+               values[c] = ReadMapped(static_cast<const perf_event_mmap_page*>(pages[c]));
+            }
+         }
+         else
+            ReadGroup(hardware, values);
+
+         ReadGroup(software, values);
+      #endif
+   }
+
+   #if LANGULUS_PROFILER_HAS_PERF()
+      /// Read a group of counters with a single syscall                      
+      ///   @param group - the group to read                                  
+      ///   @param values - [out] the values of the group's counters          
+      void CounterGroup::ReadGroup(const Group& group, CounterValues& values) noexcept {
+         if (group.leader == -1)
+            return;
+
+         // A group read returns the number of counters, followed by    
+         // their values in the order they were opened                  
+         uint64_t buffer[1 + Count];
+         const auto size = static_cast<ssize_t>(sizeof(uint64_t) * (1 + group.size));
+         if (::read(group.leader, buffer, sizeof(buffer)) < size)
+            return;
+
+         for (size_t i = 0; i < group.size; ++i)
+            values[group.order[i]] = buffer[1 + i];
+      }
+   #endif
+
+} // namespace Langulus::Profiler
@@ -0,0 +1,115 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#pragma once
+#include <Langulus/Core/Config.hpp>
+#include <array>
+#include <cstdint>
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be included if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+#if LANGULUS_OS_LINUX() or LANGULUS_OS_ANDROID()
+   #define LANGULUS_PROFILER_HAS_PERF() 1
+#else
+   #define LANGULUS_PROFILER_HAS_PERF() 0
+#endif
+
+namespace Langulus::Profiler
+{
+
+   ///                                                                        
+   /// Hardware and software performance counters, that can be read per scope 
+   ///                                                                        
+   enum class Counter : uint32_t {
+      Cycles,
+      Instructions,
+      CacheMisses,
+      BranchMisses,
+      PageFaults,
+      ContextSwitches,
+      Count
+   };
+
+   constexpr const char* CounterNames[] {
+      "cycles", "instructions", "cache misses", "branch misses",
+      "page faults", "context switches"
+   };
+
+   /// A set of counters, one bit per Counter                                 
+   using CounterMask = uint32_t;
+   constexpr CounterMask AllCounters = (1u << static_cast<uint32_t>(Counter::Count)) - 1;
+
+   /// Get the bit of a counter in a CounterMask                              
+   ///   @param c - the counter                                               
+   ///   @return the bit                                                      
+   constexpr CounterMask Mask(Counter c) noexcept {
+      return 1u << static_cast<uint32_t>(c);
+   }
+
+   /// The counters of the CPU's PMU, which can be read in user space         
+   constexpr CounterMask HardwareCounters = Mask(Counter::Cycles)
+      | Mask(Counter::Instructions) | Mask(Counter::CacheMisses)
+      | Mask(Counter::BranchMisses);
+
+   /// The counters kept by the kernel, which cost a syscall per read         
+   constexpr CounterMask SoftwareCounters = AllCounters & ~HardwareCounters;
+
+   /// Values of all counters, indexed by Counter                             
+   using CounterValues = ::std::array<uint64_t, static_cast<size_t>(Counter::Count)>;
+
+
+   ///                                                                        
+   /// The performance counters of a single thread, opened with               
+   /// perf_event_open as two groups - the hardware counters, and the         
+   /// software ones - so that each group is counted over the same            
+   /// instructions. Counters that can't be opened - hardware ones in most    
+   /// VMs, or all of them on other platforms - are left out, and read as     
+   /// zero. When the kernel allows it, hardware counters are read in user    
+   /// space with rdpmc, otherwise their group is read with a single          
+   /// syscall. Software counters always cost a syscall per read              
+   ///                                                                        
+   struct CounterGroup {
+   private:
+      static constexpr size_t Count = static_cast<size_t>(Counter::Count);
+
+      /// A perf_event group, read as a whole with a single syscall           
+      struct Group {
+         int leader = -1;
+         // The counters in the order the group read returns them       
+         ::std::array<uint8_t, Count> order {};
+         size_t size = 0;
+      };
+
+      Group hardware;
+      Group software;
+      ::std::array<int, Count> fds {-1, -1, -1, -1, -1, -1};
+      ::std::array<void*, Count> pages {};
+      size_t      page_size = 0;
+      CounterMask opened = 0;
+      bool        mapped = false;
+
+      LANGULUS_API(PROFILER) static void ReadGroup(const Group&, CounterValues&) noexcept;
+
+   public:
+      CounterGroup() = default;
+      CounterGroup(const CounterGroup&) = delete;
+      LANGULUS_API(PROFILER) ~CounterGroup();
+
+      LANGULUS_API(PROFILER) CounterMask Open(CounterMask) noexcept;
+      LANGULUS_API(PROFILER) void Close() noexcept;
+      LANGULUS_API(PROFILER) void Read(CounterValues&) const noexcept;
+
+      /// Get the counters that were opened                                   
+      ///   @return the mask of opened counters                               
+      CounterMask Opened() const noexcept {
+         return opened;
+      }
+   };
+
+} // namespace Langulus::Profiler
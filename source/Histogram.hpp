@@ -0,0 +1,107 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#pragma once
+#include <Langulus/Core/Config.hpp>
+#include <array>
+#include <bit>
+#include <limits>
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be included if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+namespace Langulus::Profiler
+{
+
+   ///                                                                        
+   /// A log-linear latency histogram of fixed size                           
+   /// Every power of two of nanoseconds is split into SubBuckets linear      
+   /// buckets, so that any recorded value is known within 1/SubBuckets of    
+   /// itself, from a nanosecond up to about 18 minutes, where it clamps.     
+   /// Counts saturate instead of wrapping, and histograms merge by adding    
+   /// their counts up                                                        
+   ///                                                                        
+   struct Histogram {
+      static constexpr unsigned SubBits = 4;
+      static constexpr unsigned SubBuckets = 1u << SubBits;
+      static constexpr unsigned MaxExponent = 39;
+      static constexpr unsigned Buckets = (MaxExponent - SubBits + 2) * SubBuckets;
+
+      using Count = uint32_t;
+      ::std::array<Count, Buckets> counts {};
+
+      /// Get the bucket a value falls in                                     
+      ///   @param ns - the value in nanoseconds                              
+      ///   @return the index of the bucket                                   
+      static constexpr unsigned Index(uint64_t ns) noexcept {
+         if (ns < SubBuckets)
+            return static_cast<unsigned>(ns);
+
+         const unsigned e = ::std::bit_width(ns) - 1;
+         if (e > MaxExponent)
+            return Buckets - 1;
+
+         const auto sub = static_cast<unsigned>(ns >> (e - SubBits)) & (SubBuckets - 1);
+         return (e - SubBits + 1) * SubBuckets + sub;
+      }
+
+      /// Get the middle of the values a bucket holds                         
+      ///   @param index - the index of the bucket                            
+      ///   @return the value in nanoseconds                                  
+      static constexpr uint64_t Value(unsigned index) noexcept {
+         if (index < SubBuckets)
+            return index;
+
+         const unsigned shift = index / SubBuckets - 1;
+         const uint64_t low = uint64_t {SubBuckets + index % SubBuckets} << shift;
+         return low + ((uint64_t {1} << shift) >> 1);
+      }
+
+      /// Record a value                                                      
+      ///   @param ns - the value in nanoseconds                              
+      LANGULUS(ALWAYS_INLINED)
+      void Add(uint64_t ns) noexcept {
+         auto& count = counts[Index(ns)];
+         if (count != ::std::numeric_limits<Count>::max())
+            ++count;
+      }
+
+      /// Add another histogram's counts to this one                          
+      ///   @param other - the histogram to merge                             
+      void Merge(const Histogram& other) noexcept {
+         for (unsigned i = 0; i < Buckets; ++i) {
+            const auto room = ::std::numeric_limits<Count>::max() - counts[i];
+            counts[i] += other.counts[i] < room ? other.counts[i] : room;
+         }
+      }
+
+      /// Get the value below which a portion of the recorded values falls    
+      ///   @param q - the portion, in the range [0; 1]                       
+      ///   @return the value in nanoseconds, or zero if nothing was recorded 
+      uint64_t Percentile(double q) const noexcept {
+         uint64_t total = 0;
+         for (auto c : counts)
+            total += c;
+         if (not total)
+            return 0;
+
+         auto rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+         if (rank < 1)
+            rank = 1;
+
+         uint64_t seen = 0;
+         for (unsigned i = 0; i < Buckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank)
+               return Value(i);
+         }
+         return Value(Buckets - 1);
+      }
+   };
+
+} // namespace Langulus::Profiler
@@ -5,9 +5,14 @@
 ///                                                                           
 /// SPDX-License-Identifier: MIT                                              
 ///                                                                           
-#include <Langulus/Profiler.hpp>
+#include "Trace.hpp"
 #include <Langulus/Core/Assume.hpp>
 #include <fmt/chrono.h>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
 
 #if not LANGULUS_FEATURE(PROFILING)
    #error This file shouldn't be built at all if LANGULUS_FEATURE_PROFILING is disabled
@@ -19,6 +24,270 @@ namespace Langulus::Profiler
 
    State Instance {};
 
+   /// Get how deep the calling thread is in an entry skipped by sampling     
+   /// Everything nested in a skipped entry is skipped with it, so that none  
+   /// of it gets attached to the wrong parent, and everything nested in a    
+   /// measured entry is extrapolated with it. Kept in the library, so that   
+   /// scopes in every module see the same depth - an inline variable would   
+   /// get a copy in each shared library                                      
+   ///   @return the calling thread's depth                                   
+   uint32_t& Skipping() noexcept {
+      thread_local uint32_t depth = 0;
+      return depth;
+   }
+
+   namespace
+   {
+      /// The calling thread's profiler state, registered on first use        
+      thread_local State::Thread* CurrentThread = nullptr;
+
+      /// Closes the calling thread's performance counters when it exits      
+      /// The thread's state outlives it, for the report, but its counters    
+      /// would otherwise stay open until the profiler is destroyed           
+      struct CounterCloser {
+         State::Thread* thread = nullptr;
+
+         ~CounterCloser() {
+            if (thread) {
+               thread->counters.Close();
+               thread->counters_requested = 0;
+            }
+         }
+      };
+
+      thread_local CounterCloser ThreadCounters;
+
+      /// Hash a result's key                                                 
+      ///   @param parent - the parent node                                   
+      ///   @param descriptor - the id of the measurement site                
+      ///   @return the hash                                                  
+      inline uint64_t HashNode(Node parent, uint32_t descriptor) noexcept {
+         uint64_t x = (uint64_t {parent} << 32) | descriptor;
+         x ^= x >> 30;
+         x *= 0xBF58476D1CE4E5B9ull;
+         x ^= x >> 27;
+         x *= 0x94D049BB133111EBull;
+         return x ^ (x >> 31);
+      }
+
+      /// Match text against a glob, where '*' matches any run of characters, 
+      /// and '?' matches any single character                                
+      ///   @param glob - the pattern                                         
+      ///   @param text - the text to match                                   
+      ///   @return true if the whole text matches                            
+      bool Matches(::std::string_view glob, ::std::string_view text) noexcept {
+         size_t g = 0;
+         size_t t = 0;
+         size_t star = ::std::string_view::npos;
+         size_t resume = 0;
+         while (t < text.size()) {
+            if (g < glob.size() and (glob[g] == '?' or glob[g] == text[t])) {
+               ++g;
+               ++t;
+            }
+            else if (g < glob.size() and glob[g] == '*') {
+               // Try matching nothing first, and backtrack to consume  
+               // one more character each time the rest fails           
+               star = g++;
+               resume = t;
+            }
+            else if (star != ::std::string_view::npos) {
+               g = star + 1;
+               t = ++resume;
+            }
+            else
+               return false;
+         }
+
+         while (g < glob.size() and glob[g] == '*')
+            ++g;
+         return g == glob.size();
+      }
+
+      /// Format an amount with a decimal prefix, like 1.5 GB, or 1.5 M items 
+      ///   @param amount - the amount                                        
+      ///   @param unit - the unit, only symbols are fused with the prefix    
+      ///   @return the formatted amount                                      
+      String Scaled(double amount, const char* unit) {
+         constexpr const char* prefixes[] {"", "k", "M", "G", "T", "P"};
+         size_t p = 0;
+         while (amount >= 1000 and p + 1 < ::std::size(prefixes)) {
+            amount /= 1000;
+            ++p;
+         }
+         const bool symbol = unit[0] and not unit[1];
+         return fmt::format("{:.3g} {}{}{}", amount, prefixes[p], p and not symbol ? " " : "", unit);
+      }
+
+      /// Marks a thread as busy inside the profiler for as long as it lives, 
+      /// so that the profiler's own allocations aren't attributed to         
+      /// measurements                                                        
+      struct Busy {
+         State::Thread* thread;
+
+         Busy(State::Thread* t) noexcept
+            : thread {t} {
+            if (thread)
+               thread->busy = true;
+         }
+
+         ~Busy() {
+            if (thread)
+               thread->busy = false;
+         }
+      };
+
+      /// Construct a measurement in one of the thread's recycled slots       
+      ///   @param thread - the thread state to allocate in                   
+      ///   @param args... - arguments for the measurement's constructor      
+      ///   @return the new measurement                                       
+      template<class...A>
+      auto NewMeasurement(State::Thread& thread, A&&...args) -> State::Measurement* {
+         if (not thread.free_slots) {
+            // Out of slots, so add a new block - happens only when the 
+            // thread reaches a new maximum of concurrent measurements  
+            using Slot = State::Thread::Slot;
+            constexpr auto count = State::Thread::SlotsPerBlock;
+            auto& block = thread.blocks.emplace_back(
+               ::std::make_unique<Slot[]>(count));
+            for (size_t i = 0; i < count; ++i) {
+               block[i].next = thread.free_slots;
+               thread.free_slots = &block[i];
+            }
+         }
+
+         auto slot = thread.free_slots;
+         thread.free_slots = slot->next;
+         return new (slot->storage) State::Measurement {::std::forward<A>(args)...};
+      }
+
+      /// Add to a result's total time in the thread's running frame          
+      ///   @param thread - the thread marking frames                         
+      ///   @param n - the result                                             
+      ///   @param time - the time the result ran in the frame                
+      void Spend(State::Thread& thread, Node n, Time time) {
+         if (n >= thread.frame_total.size())
+            thread.frame_total.resize(thread.results.Size(), Time::zero());
+
+         // A result may run for zero ticks and be listed again, but    
+         // the frame takes only its first listing                      
+         auto& total = thread.frame_total[n];
+         if (total == Time::zero())
+            thread.frame_nodes.push_back(n);
+         total += time;
+      }
+
+      /// Write the frame history of a thread: a graph of the frame times,    
+      /// and the worst frames, with the results that took longer than usual  
+      /// in each of them. A result's time includes its nested results, so    
+      /// it's only blamed for the part of its excess that its nested         
+      /// results don't account for                                           
+      ///   @param out - the stream to write to                               
+      ///   @param results - the results the frames refer to                  
+      ///   @param thread - the index of the thread that marked the frames    
+      ///   @param main - whether that's the main thread                      
+      ///   @param first - the number of the oldest frame                     
+      ///   @param frames - the frames, oldest first                          
+      void WriteFrames(::std::ostream& out, const Database& results, size_t thread, bool main, size_t first, const ::std::vector<Frame>& frames) {
+         if (frames.empty())
+            return;
+
+         // Each result's average time per frame, so that spikes are    
+         // blamed on the results that exceeded theirs                  
+         ::std::vector<double> usual(results.Size(), 0.0);
+         Time sum = Time::zero();
+         Time worst = Time::zero();
+         for (auto& frame : frames) {
+            sum += frame.duration;
+            worst = ::std::max(worst, frame.duration);
+            for (auto [n, total] : frame.scopes)
+               usual[n] += RealMs(total);
+         }
+         for (auto& u : usual)
+            u /= static_cast<double>(frames.size());
+
+         ::std::vector<size_t> order(frames.size());
+         ::std::iota(order.begin(), order.end(), size_t {0});
+         ::std::ranges::sort(order, [&](size_t a, size_t b) {
+            return frames[a].duration < frames[b].duration;
+         });
+         const auto median = frames[order[order.size() / 2]].duration;
+         const auto average = sum / static_cast<Time::rep>(frames.size());
+
+         out << "<details open><summary><h3>Frames of "
+             << (main ? String {"the main thread"} : fmt::format("thread {}", thread))
+             << "</h3></summary>\n";
+         out << "<div>- last " << frames.size() << " frames: avg " << RealMs(average)
+             << " ms, median " << RealMs(median) << " ms, worst " << RealMs(worst) << " ms;</div>\n";
+         out << "<div>- scopes are timed in each frame they ran in, nested scopes included, "
+                "and blamed only for the excess their nested scopes don't account for;</div>\n";
+
+         // Frames that took more than twice the median are spikes      
+         constexpr int BarWidth = 3;
+         constexpr int Height = 64;
+         const auto scale = worst > Time::zero() ? Height / RealMs(worst) : 0;
+         out << "<div><svg width=\"" << frames.size() * BarWidth
+             << "\" height=\"" << Height << "\" style=\"background-color: #181818;\">";
+         for (size_t f = 0; f < frames.size(); ++f) {
+            const auto ms = RealMs(frames[f].duration);
+            const auto h = ::std::max(1, static_cast<int>(ms * scale));
+            out << "<rect x=\"" << f * BarWidth << "\" y=\"" << Height - h
+                << "\" width=\"" << BarWidth - 1 << "\" height=\"" << h << "\" fill=\""
+                << (frames[f].duration > 2 * median ? "OrangeRed" : "SteelBlue")
+                << "\"><title>frame " << first + f << ": " << ms << " ms</title></rect>";
+         }
+         out << "</svg></div>\n";
+
+         // The worst frames, slowest first                             
+         constexpr size_t WorstFrames = 5;
+         constexpr size_t Culprits = 3;
+         out << "<div>worst frames:</div>\n";
+         ::std::vector<::std::pair<double, Node>> excess;
+         ::std::vector<double> over(results.Size(), 0.0);
+         ::std::vector<double> own(results.Size(), 0.0);
+         for (size_t i = 0; i < ::std::min(WorstFrames, order.size()); ++i) {
+            const auto f = order[order.size() - 1 - i];
+            const auto& frame = frames[f];
+            out << "<div>- frame " << first + f << ": " << RealMs(frame.duration) << " ms";
+            if (median > Time::zero()) {
+               out << " (" << fmt::format("{:.1f}", RealMs(frame.duration) / RealMs(median))
+                   << "x the median)";
+            }
+
+            // Each result's excess over its usual, less the excess of  
+            // the results nested in it - results that ran in the frame 
+            // have a parent that ran in it too, unless they're roots   
+            for (auto [n, total] : frame.scopes)
+               over[n] = RealMs(total) - usual[n];
+            for (auto [n, total] : frame.scopes) {
+               const auto parent = results.parent[n];
+               if (parent != NoNode and over[n] > 0)
+                  own[parent] -= over[n];
+            }
+
+            // Results over their usual by less than a percent of the   
+            // frame aren't worth blaming                               
+            excess.clear();
+            const auto threshold = RealMs(frame.duration) / 100;
+            for (auto [n, total] : frame.scopes) {
+               const auto blame = over[n] + ::std::exchange(own[n], 0.0);
+               if (blame > threshold)
+                  excess.emplace_back(blame, n);
+            }
+
+            const auto culprits = ::std::min(Culprits, excess.size());
+            ::std::ranges::partial_sort(excess, excess.begin() + culprits, ::std::ranges::greater {});
+            for (size_t c = 0; c < culprits; ++c) {
+               out << (c ? ", " : " - most over the usual: ")
+                   << results.descriptor[excess[c].second]->name
+                   << " +" << fmt::format("{:.3f}", excess[c].first) << " ms";
+            }
+            out << ";</div>\n";
+         }
+         out << "</details>\n";
+      }
+   }
+
 
    /// Configure the profiler                                                 
    ///   @param profiling_file - file to write results into                   
@@ -26,63 +295,1180 @@ namespace Langulus::Profiler
    void State::Configure(String&& profiling_file, Time interval) noexcept {
       output_file = ::std::forward<String>(profiling_file);
       output_interval = interval;
-      last_output_timestamp = Clock::now();
+      last_output_timestamp = timer.Now();
    }
 
-   /// Begin a scoped measurement                                             
+   /// Also write folded stacks for flamegraphs on each dump                  
+   ///   @param folded - file to write folded stacks into, empty to disable   
+   ///   @param per_build - whether to root each stack in its build           
+   void State::ConfigureFolded(String&& folded, bool per_build) noexcept {
+      folded_file = ::std::forward<String>(folded);
+      folded_per_build = per_build;
+   }
+
+   /// Let the profiler throttle measurement sites that distort their callers 
+   /// On each dump, sites whose instrumentation costs more than the budget   
+   /// portion of their average duration get sampled, or disabled, and are    
+   /// listed in the report                                                   
+   ///   @param budget - the tolerated portion, such as 0.05 for 5%, or zero  
+   ///      to stop governing - sites that were already throttled stay so     
+   ///   @param overhead - the cost of measuring a single entry, zero to use  
+   ///      the one calibrated on startup                                     
+   void State::ConfigureGovernor(Real budget, Time overhead) noexcept {
+      governor_budget.store(budget, ::std::memory_order_relaxed);
+      governor_overhead.store(overhead, ::std::memory_order_relaxed);
+   }
+
+   /// Measure the outermost levels of recursive sites as results of their    
+   /// own, nested in one another, so that each level's cost is reported      
+   /// Entries deeper than that are folded into the innermost measured one,   
+   /// which only counts them                                                 
+   ///   @param levels - one to measure only the outermost entry              
+   void State::ConfigureRecursion(uint32_t levels) noexcept {
+      recursion_levels.store(levels ? levels : 1, ::std::memory_order_relaxed);
+   }
+
+   /// Count hardware and software performance events in every measured scope 
+   /// Each thread opens the counters when its outermost scope starts, so     
+   /// threads that are already inside a scope pick the change up once they   
+   /// leave it, and closes them when it exits. Counters the kernel refuses   
+   /// to open, such as the hardware ones in most virtual machines, are       
+   /// listed in the report and left out. Hardware counters are read in user  
+   /// space where the kernel allows it, but each SoftwareCounters one costs  
+   /// a syscall per scope, so they're only counted when requested            
+   ///   @param counters - the counters to open, zero to stop counting        
+   void State::ConfigureCounters(CounterMask counters) noexcept {
+      counter_mask.store(counters & AllCounters, ::std::memory_order_relaxed);
+   }
+
+   /// Get the state of the calling thread, registering it on first use       
+   ///   @return the thread state                                             
+   auto State::AcquireThread() -> Thread& {
+      if (CurrentThread)
+         return *CurrentThread;
+
+      ::std::scoped_lock lock {threads_guard};
+      auto& thread = threads.emplace_back(::std::make_unique<Thread>());
+      thread->id = ::std::this_thread::get_id();
+      thread->index = threads.size() - 1;
+      CurrentThread = thread.get();
+      return *thread;
+   }
+
+   /// Register a measurement site, or get the descriptor of an already       
+   /// registered site with the same name and build                           
    ///   @param n - the name of the measurement, usually the function name    
-   ///   @param b - the build configuration (should be inline-generated)      
-   ///   @return the auto-stopper                                             
-   auto State::Start(String&& n, Build&& b) -> Stopper {
-      auto stack = main;
-      if (not stack) {
-         // First measurement is always the master measurement          
-         // Place it in your main function                              
-         main = new Measurement (
+   ///   @param file - the file of the measurement site                       
+   ///   @param line - the line of the measurement site                       
+   ///   @param b - the build of the site's translation unit                  
+   ///   @param period - measure only every Nth entry, one to measure all     
+   ///   @param category - the subsystem the site belongs to, for filtering   
+   ///   @return the interned descriptor                                      
+   auto State::Register(String&& n, String&& file, uint32_t line, const Build& b, uint32_t period, String&& category) -> const Descriptor& {
+      const auto id = b.ID();
+      const Busy busy {CurrentThread};
+      ::std::scoped_lock lock {descriptors_guard};
+      auto decoded = builds.try_emplace(id, b);
+      LANGULUS_ASSUME(DevAssumes, decoded.first->second == b,
+         "Build fingerprint collision"
+      );
+
+      auto& found = descriptor_index[n][id];
+      if (not found) {
+         found = &descriptors.emplace_back(
             ::std::forward<String>(n),
-            ::std::forward<Build>(b),
-            nullptr
+            ::std::forward<String>(file),
+            line, id,
+            static_cast<uint32_t>(descriptors.size()),
+            ::std::forward<String>(category)
          );
-         return main;
+         found->enabled.store(Allows(*found), ::std::memory_order_relaxed);
+      }
+
+      if (period != 1)
+         Sample(*found, period);
+      return *found;
+   }
+
+   /// Measure only every Nth entry of a measurement site                     
+   /// Each measured entry is counted N times, so that totals and call        
+   /// counts are extrapolated, and reported as estimated                     
+   ///   @param d - the measurement site                                      
+   ///   @param period - one to measure every entry                           
+   void State::Sample(const Descriptor& d, uint32_t period) noexcept {
+      d.period.store(period ? period : 1, ::std::memory_order_relaxed);
+   }
+
+   /// Enable or disable all sites of the categories that match a glob        
+   ///   @param glob - the categories to match, such as "render" or "IO*"     
+   ///   @param enable - whether to enable the matching sites                 
+   void State::EnableCategory(String&& glob, bool enable) {
+      AddFilter({::std::forward<String>(glob), true, enable});
+   }
+
+   /// Enable or disable all sites with names that match a glob               
+   ///   @param glob - the names to match, such as "*Scene::*"                
+   ///   @param enable - whether to enable the matching sites                 
+   void State::EnableScopes(String&& glob, bool enable) {
+      AddFilter({::std::forward<String>(glob), false, enable});
+   }
+
+   /// Remove all filters, enabling every site again                          
+   void State::ResetFilters() {
+      ::std::scoped_lock lock {descriptors_guard};
+      filters.clear();
+      for (auto& d : descriptors)
+         d.enabled.store(true, ::std::memory_order_relaxed);
+   }
+
+   /// Add a filter on top of the others, and apply it to all sites           
+   /// Only sites the filter matches can change, so the others are left as    
+   /// they are                                                               
+   ///   @param filter - the filter to add                                    
+   void State::AddFilter(Filter&& filter) {
+      ::std::scoped_lock lock {descriptors_guard};
+      const auto& f = filters.emplace_back(::std::forward<Filter>(filter));
+      for (auto& d : descriptors) {
+         if (Matches(f.pattern, f.category ? d.category : d.name))
+            d.enabled.store(f.enable, ::std::memory_order_relaxed);
       }
+   }
+
+   /// Check if the filters allow measuring a site                            
+   /// The descriptors' guard must be locked                                  
+   ///   @param d - the site                                                  
+   ///   @return true if the last filter that matches enables the site, or    
+   ///      if no filter matches                                              
+   bool State::Allows(const Descriptor& d) const noexcept {
+      for (auto f = filters.rbegin(); f != filters.rend(); ++f) {
+         if (Matches(f->pattern, f->category ? d.category : d.name))
+            return f->enable;
+      }
+      return true;
+   }
+
+   /// Select how measurements are compiled into results                      
+   /// Each thread switches to the new mode when its outermost scope starts,  
+   /// so that a measurement is never split between the two modes             
+   ///   @param m - the new mode                                              
+   void State::Configure(Mode m) noexcept {
+      mode = m;
+      if (m == Mode::Deferred and not aggregating.exchange(true))
+         aggregator = ::std::thread {[this] { Aggregate(); }};
+   }
+
+   /// Calibrate the profiler's own overhead on this machine                  
+   State::State() {
+      main_thread = ::std::this_thread::get_id();
+      Calibrate();
+   }
+
+   /// Measure empty scopes in both modes, through the same inline Start and  
+   /// the same Stopper that instrumented code uses, clock reads, thread      
+   /// lookup, recursion bookkeeping and the check for a dump included. They  
+   /// are measured on a private thread state that nothing else sees, nested  
+   /// in a parent scope, like most scopes are. The median of a few rounds is 
+   /// kept, so that neither the first round, which warms up the caches, nor  
+   /// preemptions skew the result                                            
+   void State::Calibrate() {
+      constexpr int Rounds = 9;
+      constexpr Ticks Entries = 1000;
+      static_assert(Entries * 2 < Thread::RingSize,
+         "Calibrating deferred mode must never fill up the ring");
+
+      Thread probe;
+      const auto previous = ::std::exchange(CurrentThread, &probe);
+      const Descriptor parent {};
+      Descriptor site {};
+      site.id = 1;
+
+      // Keep the probe from asking for dumps, while still checking     
+      last_output_timestamp.store(~Ticks {0});
 
-      // Otherwise add the new measurement as a child to the previous   
-      while (stack->child) {
-         // Avoid nesting calls - only the top level is measured        
-         if (stack->child->name == n and stack->child->build == b)
-            return {};
+      for (auto m : {Mode::Immediate, Mode::Deferred}) {
+         Ticks inner[Rounds];
+         Ticks outer[Rounds];
 
-         stack = stack->child;
+         // The parent scope latches the mode on the probe              
+         mode.store(m);
+         uint32_t skip = 0;
+         auto scope = Profiler::Start(parent, skip);
+
+         // Recorded events get compiled while more are being recorded, 
+         // the way the aggregator does it                              
+         ::std::atomic_bool draining = m == Mode::Deferred;
+         ::std::thread drainer;
+         if (draining) {
+            drainer = ::std::thread {[&] {
+               while (draining.load(::std::memory_order_relaxed)) {
+                  ::std::scoped_lock lock {probe.guard};
+                  Drain(probe);
+               }
+            }};
+         }
+
+         for (int round = 0; round < Rounds; ++round) {
+            const auto start = timer.Now();
+            for (Ticks i = 0; i < Entries; ++i)
+               const auto entry = Profiler::Start(site, skip);
+            outer[round] = (timer.Now() - start) / Entries;
+
+            // The durations the entries were measured with are their   
+            // inner cost, as compiled into their result                
+            ::std::scoped_lock lock {probe.guard};
+            Drain(probe);
+            const auto n = probe.results.Child(probe.top->compiled, site);
+            const auto ns = ::std::chrono::duration<double, ::std::nano>(
+               probe.results.total[n]).count() / static_cast<double>(probe.results.calls[n]);
+            probe.results.total[n] = Time::zero();
+            probe.results.calls[n] = 0;
+
+            inner[round] = static_cast<Ticks>(ns / timer.NsPerTick());
+         }
+
+         draining = false;
+         if (drainer.joinable())
+            drainer.join();
+
+         ::std::ranges::nth_element(inner, inner + Rounds / 2);
+         ::std::ranges::nth_element(outer, outer + Rounds / 2);
+         overhead[static_cast<int>(m)] = {inner[Rounds / 2], outer[Rounds / 2]};
       }
 
-      LANGULUS_ASSUME(DevAssumes, not stack->child,
-         "A measurement already has children"
+      mode.store(Mode::Immediate);
+      last_output_timestamp.store(timer.Now());
+      CurrentThread = previous;
+   }
+
+   /// Stop the aggregator, if running, and compile whatever was recorded     
+   /// after its last pass - this is usually the main thread's master         
+   /// measurement, so the final results get written here. Then stop the      
+   /// background writer, if running, and finish the trace                    
+   State::~State() {
+      if (aggregating.exchange(false)) {
+         aggregator.join();
+         for (auto& thread : threads) {
+            bool main_ended;
+            {
+               ::std::scoped_lock lock {thread->guard};
+               main_ended = Drain(*thread);
+            }
+            Closed(*thread, main_ended, timer.Now());
+         }
+      }
+
+      {
+         ::std::scoped_lock lock {writer_guard};
+         writer_stopping = true;
+      }
+      writer_signal.notify_one();
+      if (writer.joinable())
+         writer.join();
+
+      // Stream whatever the writer didn't get to, and seal the trace   
+      FlushTrace();
+      if (trace_file.is_open())
+         trace_file.close();
+
+      // The thread states are about to go away, but allocations made   
+      // during the rest of the static destruction still get reported   
+      CurrentThread = nullptr;
+   }
+
+   /// Begin a scoped measurement                                             
+   /// Whether the site is enabled, and whether the entry is skipped by       
+   /// sampling, is checked by Profiler::Start, inline                        
+   ///   @param d - the registered measurement site                           
+   ///   @param weight - how many entries the measured one stands for         
+   ///   @return the auto-stopper                                             
+   auto State::Start(const Descriptor& d, uint32_t weight) -> Stopper {
+      auto& thread = AcquireThread();
+      const Busy busy {&thread};
+      if (d.id >= thread.depth.size()) {
+         thread.depth.resize(d.id + 1, 0);
+         thread.folds.resize(d.id + 1, 0);
+         thread.deepest.resize(d.id + 1, 0);
+      }
+
+      // Recursive entries beyond the measured levels only get counted  
+      // for the innermost measured one, to be compiled when it stops   
+      auto& depth = thread.depth[d.id];
+      if (depth >= recursion_levels.load(::std::memory_order_relaxed)) {
+         ++depth;
+         ++thread.folds[d.id];
+         if (depth > thread.deepest[d.id])
+            thread.deepest[d.id] = depth;
+         return {thread, d, true};
+      }
+      ++depth;
+
+      if (not thread.open++) {
+         // Outermost scope on this thread, so it's safe to switch mode 
+         const bool deferred = mode.load(::std::memory_order_relaxed) == Mode::Deferred;
+         if (deferred != thread.deferred) {
+            // Draining may end the master measurement, which is reacted
+            // on the same way the aggregator does                      
+            bool main_ended = false;
+            {
+               ::std::scoped_lock lock {thread.guard};
+               if (deferred and not thread.ring)
+                  thread.ring = ::std::make_unique<Event[]>(Thread::RingSize);
+               else if (not deferred)
+                  main_ended = Drain(thread);
+               thread.deferred = deferred;
+            }
+            Closed(thread, main_ended, timer.Now());
+         }
+
+         // ...and to reopen the counters                               
+         const auto requested = counter_mask.load(::std::memory_order_relaxed);
+         if (requested != thread.counters_requested) {
+            thread.counters_requested = requested;
+            if (requested) {
+               const auto opened = thread.counters.Open(requested);
+               counters_missing.fetch_or(requested & ~opened, ::std::memory_order_relaxed);
+               ThreadCounters.thread = &thread;
+            }
+            else
+               thread.counters.Close();
+         }
+      }
+
+      if (thread.deferred)
+         Record(thread, {&d, timer.Now(), weight});
+      else {
+         ::std::scoped_lock lock {thread.guard};
+         const auto m = Open(thread, d, weight);
+         m->start = timer.Now();
+         if (tracing.load(::std::memory_order_relaxed))
+            Trace::PutBegin(thread.trace, thread.trace_last, m->start, d.id, m->weight);
+      }
+
+      // Counters are read last, so that they count as little of the    
+      // profiler itself as possible                                    
+      if (thread.counters.Opened())
+         thread.counters.Read(thread.counter_starts.emplace_back());
+      return {thread, d};
+   }
+
+   /// Stop a scoped measurement                                              
+   ///   @param thread - the thread that started the measurement              
+   ///   @param d - the measurement site                                      
+   void State::Stop(Thread& thread, const Descriptor& d) noexcept {
+      CounterValues counters;
+      if (thread.counters.Opened())
+         thread.counters.Read(counters);
+
+      const auto now = timer.Now();
+      const Busy busy {&thread};
+      --thread.depth[d.id];
+      --thread.open;
+
+      // Counters are opened only between outermost scopes, so every    
+      // measured scope has its start values on the stack               
+      const bool counting = not thread.counter_starts.empty();
+      if (counting) {
+         const auto& start = thread.counter_starts.back();
+         for (size_t c = 0; c < counters.size(); ++c)
+            counters[c] -= start[c];
+         thread.counter_starts.pop_back();
+      }
+
+      // Hand over the recursive entries folded into this one           
+      const auto folds = ::std::exchange(thread.folds[d.id], 0);
+      const auto deepest = ::std::exchange(thread.deepest[d.id], 0);
+      if (thread.deferred) {
+         if (counting) {
+            for (uint32_t c = 0; c < counters.size(); ++c) {
+               if (counters[c])
+                  Record(thread, {nullptr, counters[c], c, 0, Event::Counter});
+            }
+         }
+         Record(thread, {nullptr, now, folds, deepest});
+         return;
+      }
+
+      bool main_ended;
+      {
+         ::std::scoped_lock lock {thread.guard};
+         if (counting)
+            thread.top->counters = counters;
+         main_ended = Close(thread, now, folds, deepest);
+      }
+      Closed(thread, main_ended, now);
+   }
+
+   /// Stop a recursive entry that was folded into an outer one               
+   ///   @param thread - the thread that started the entry                    
+   ///   @param d - the measurement site                                      
+   void State::Unfold(Thread& thread, const Descriptor& d) noexcept {
+      --thread.depth[d.id];
+   }
+
+   /// Count work done by the calling thread's innermost running measurement  
+   /// In deferred mode the work is recorded as an event, so that it's        
+   /// attributed to the right measurement when the events are compiled       
+   ///   @param amount - how much work was done                               
+   ///   @param unit - what was counted                                       
+   void State::Count(uint64_t amount, Unit unit) noexcept {
+      const auto thread = CurrentThread;
+      if (not thread or not thread->open)
+         return;
+
+      // Units that don't exist are ignored, instead of being counted   
+      // past the end of the measurement's work                         
+      if (static_cast<uint32_t>(unit) >= Measurement::UnitCount)
+         return;
+
+      if (thread->deferred) {
+         const Busy busy {thread};
+         Record(*thread, {nullptr, amount, static_cast<uint32_t>(unit), 0, Event::Work});
+         return;
+      }
+
+      // Only the thread itself moves its top in immediate mode, and    
+      // nothing else reads the work, so no locking is needed           
+      thread->top->work[static_cast<int>(unit)] += amount;
+   }
+
+   /// Count a heap allocation done by the calling thread, to its innermost   
+   /// running measurement - called by the replaced operator new, see         
+   /// Allocations.cpp, or by any custom allocator. Threads that never        
+   /// measured anything are ignored, and nothing here allocates or locks,    
+   /// so allocations made by the profiler itself can't recurse               
+   ///   @param size - the size of the allocation in bytes                    
+   void State::Allocated(size_t size) noexcept {
+      const auto thread = CurrentThread;
+      if (not thread or not thread->open or thread->busy)
+         return;
+
+      if (thread->deferred)
+         Post(*thread, {nullptr, size, 0, 0, Event::Allocation});
+      else if (thread->top)
+         thread->top->Allocate(size);
+   }
+
+   /// Count a heap deallocation done by the calling thread, to its           
+   /// innermost running measurement - see Allocated()                        
+   ///   @param size - the size of the allocation in bytes                    
+   void State::Freed(size_t size) noexcept {
+      const auto thread = CurrentThread;
+      if (not thread or not thread->open or thread->busy)
+         return;
+
+      if (thread->deferred)
+         Post(*thread, {nullptr, size, 0, 0, Event::Deallocation});
+      else if (thread->top)
+         thread->top->Free(size);
+   }
+
+   /// End the calling thread's current frame, and begin the next one         
+   /// The first mark only begins a frame. In deferred mode the mark is       
+   /// recorded as an event, so that the frame ends after the measurements    
+   /// recorded before it are compiled. Threads that never measured anything  
+   /// have nothing to attribute to frames, and are ignored                   
+   void State::FrameMark() noexcept {
+      const auto now = timer.Now();
+      const auto thread = CurrentThread;
+      if (not thread)
+         return;
+
+      const Busy busy {thread};
+      if (thread->deferred) {
+         Record(*thread, {nullptr, now, 0, 0, Event::Frame});
+         return;
+      }
+
+      ::std::scoped_lock lock {thread->guard};
+      EndFrame(*thread, now);
+   }
+
+   /// End a thread's running frame, moving the total times of the results    
+   /// that ran in it into the frame history - costs only as much as there    
+   /// are results that ran. The guard of the thread must be locked           
+   ///   @param thread - the thread to end the frame of                       
+   ///   @param end - the timestamp of the frame's end                        
+   void State::EndFrame(Thread& thread, Ticks end) {
+      if (thread.framing) {
+         // Measurements still running get the part of them that ran in 
+         // this frame, and the rest goes to the frames they end in     
+         for (auto m = thread.top; m; m = m->parent)
+            Spend(thread, m->compiled, timer.ToTime(end - ::std::max(m->start, thread.frame_start)));
+
+         // Recycle the oldest frame once the history is full           
+         auto& frame = thread.frames.size() < Thread::FrameHistory
+            ? thread.frames.emplace_back()
+            : thread.frames[thread.frame_count % Thread::FrameHistory];
+         frame.start = thread.frame_start;
+         frame.duration = timer.ToTime(end - thread.frame_start);
+         frame.scopes.clear();
+         for (auto n : thread.frame_nodes) {
+            const auto total = ::std::exchange(thread.frame_total[n], Time::zero());
+            if (total != Time::zero())
+               frame.scopes.emplace_back(n, total);
+         }
+         ++thread.frame_count;
+      }
+
+      thread.frame_nodes.clear();
+      thread.frame_start = end;
+      thread.framing = true;
+   }
+
+   /// Open a measurement on top of the thread's measurement stack            
+   /// The guard of the thread must be locked                                 
+   ///   @param thread - the thread to open the measurement in                
+   ///   @param d - the measurement site                                      
+   ///   @param weight - how many entries the measurement stands for          
+   ///   @return the new measurement, its start has to be set by the caller   
+   auto State::Open(Thread& thread, const Descriptor& d, uint32_t weight) -> Measurement* {
+      // Resolve the result the measurement will be compiled into now,  
+      // while the parent's result is at hand, so closing never has to  
+      // look it up or touch any of the ancestors                       
+      const auto parent = thread.top;
+      const auto node = thread.results.Child(parent ? parent->compiled : NoNode, d);
+
+      // Entries nested in a sampled one are only measured in the       
+      // measured entries, so they're extrapolated along with it        
+      if (parent and parent->weight > 1) {
+         weight = static_cast<uint32_t>(::std::min<uint64_t>(
+            uint64_t {weight} * parent->weight,
+            ::std::numeric_limits<uint32_t>::max()
+         ));
+      }
+
+      const auto m = NewMeasurement(thread, d, parent, node, weight);
+      if (parent) {
+         // Add the new measurement as a child to the previous one      
+         LANGULUS_ASSUME(DevAssumes, not parent->child,
+            "A measurement already has children"
+         );
+         parent->child = m;
+      }
+      else {
+         // First measurement on each thread is its master measurement  
+         // Place it in your main function, or in your worker's entry   
+         thread.main = m;
+      }
+
+      thread.top = m;
+      return m;
+   }
+
+   /// Close the measurement on top of the thread's measurement stack,        
+   /// compile it into its result, and recycle its slot                       
+   /// The guard of the thread must be locked                                 
+   ///   @param thread - the thread to close the measurement in               
+   ///   @param end - the timestamp of the measurement's end                  
+   ///   @param folds - recursive entries folded into the measurement         
+   ///   @param deepest - the deepest of the folded entries                   
+   ///   @return true if the thread's master measurement was closed           
+   bool State::Close(Thread& thread, Ticks end, uint32_t folds, uint32_t deepest) {
+      const auto m = thread.top;
+      LANGULUS_ASSUME(DevAssumes, m and not m->child,
+         "Closing a measurement that isn't on top of the stack"
       );
-      stack->child = new Measurement {
-         ::std::forward<String>(n),
-         ::std::forward<Build>(b),
-         stack
+
+      m->end = end;
+      m->ended = true;
+      const auto duration = timer.ToTime(end - m->start);
+      thread.results.Integrate(m->compiled, duration, m->weight);
+      if (folds)
+         thread.results.Fold(m->compiled, folds, deepest);
+
+      // The running frame gets the part of the measurement that ran    
+      // in it, the earlier frames got the rest when they ended         
+      if (thread.framing)
+         Spend(thread, m->compiled, timer.ToTime(end - ::std::max(m->start, thread.frame_start)));
+
+      // Allocations done in a measurement were also done in its parent,
+      // on top of what the parent had live when the measurement began  
+      if (m->allocations.count or m->live) {
+         thread.results.allocations[m->compiled].Add(m->allocations, m->weight);
+         if (m->parent) {
+            auto& p = *m->parent;
+            const auto peak = p.live + static_cast<int64_t>(m->allocations.peak);
+            if (peak > 0 and static_cast<uint64_t>(peak) > p.allocations.peak)
+               p.allocations.peak = static_cast<uint64_t>(peak);
+            p.allocations.count += m->allocations.count;
+            p.allocations.bytes += m->allocations.bytes;
+            p.live += m->live;
+         }
+      }
+
+      // Work done in a measurement was also done in its parent         
+      for (uint32_t u = 0; u < Measurement::UnitCount; ++u) {
+         if (not m->work[u])
+            continue;
+         thread.results.Account(m->compiled, static_cast<Unit>(u), m->work[u], duration, m->weight);
+         if (m->parent)
+            m->parent->work[u] += m->work[u];
+      }
+
+      // Counters already include everything counted in the children    
+      for (size_t c = 0; c < m->counters.size(); ++c)
+         thread.results.counters[m->compiled][c] += m->counters[c] * m->weight;
+
+      if (tracing.load(::std::memory_order_relaxed))
+         Trace::PutEnd(thread.trace, thread.trace_last, end);
+      thread.active_builds.insert(m->descriptor->build);
+      thread.top = m->parent;
+      if (m->parent)
+         m->parent->child = nullptr;
+      else
+         thread.main = nullptr;
+
+      m->~Measurement();
+      auto slot = reinterpret_cast<Thread::Slot*>(m);
+      slot->next = thread.free_slots;
+      thread.free_slots = slot;
+      return not thread.top;
+   }
+
+   /// Compile all events recorded by a thread                                
+   /// The guard of the thread must be locked                                 
+   ///   @param thread - the thread to drain                                  
+   ///   @return true if the thread's master measurement was closed           
+   bool State::Drain(Thread& thread) {
+      auto tail = thread.ring_tail.load(::std::memory_order_relaxed);
+      const auto head = thread.ring_head.load(::std::memory_order_acquire);
+      bool main_ended = false;
+      for (; tail != head; ++tail) {
+         const auto& event = thread.ring[tail & (Thread::RingSize - 1)];
+         if (event.kind == Event::Work) {
+            if (thread.top)
+               thread.top->work[event.weight] += event.timestamp;
+         }
+         else if (event.kind == Event::Allocation) {
+            if (thread.top)
+               thread.top->Allocate(event.timestamp);
+         }
+         else if (event.kind == Event::Deallocation) {
+            if (thread.top)
+               thread.top->Free(event.timestamp);
+         }
+         else if (event.kind == Event::Counter) {
+            if (thread.top)
+               thread.top->counters[event.weight] += event.timestamp;
+         }
+         else if (event.kind == Event::Frame)
+            EndFrame(thread, event.timestamp);
+         else if (event.descriptor) {
+            const auto m = Open(thread, *event.descriptor, event.weight);
+            m->start = event.timestamp;
+            if (tracing.load(::std::memory_order_relaxed)) {
+               Trace::PutBegin(thread.trace, thread.trace_last,
+                  event.timestamp, event.descriptor->id, m->weight);
+            }
+         }
+         else
+            main_ended |= Close(thread, event.timestamp, event.weight, event.depth);
+      }
+
+      thread.ring_tail.store(tail, ::std::memory_order_release);
+      return main_ended;
+   }
+
+   /// Record an event in deferred mode                                       
+   /// If the ring is full, the thread compiles its own events on the spot    
+   ///   @param thread - the recording thread, must be the calling one        
+   ///   @param event - the event to record                                   
+   void State::Record(Thread& thread, const Event& event) noexcept {
+      const auto head = thread.ring_head.load(::std::memory_order_relaxed);
+      if (head - thread.ring_tail.load(::std::memory_order_acquire) == Thread::RingSize) {
+         // The aggregator can't keep up, so drain in place             
+         bool main_ended;
+         {
+            ::std::scoped_lock lock {thread.guard};
+            main_ended = Drain(thread);
+         }
+         Closed(thread, main_ended, timer.Now());
+      }
+
+      thread.ring[head & (Thread::RingSize - 1)] = event;
+      thread.ring_head.store(head + 1, ::std::memory_order_release);
+   }
+
+   /// Record an event in deferred mode, without ever draining the ring       
+   /// Events that don't fit are lost, and counted as such                    
+   ///   @param thread - the recording thread, must be the calling one        
+   ///   @param event - the event to record                                   
+   void State::Post(Thread& thread, const Event& event) noexcept {
+      const auto head = thread.ring_head.load(::std::memory_order_relaxed);
+      if (head - thread.ring_tail.load(::std::memory_order_acquire) == Thread::RingSize) {
+         thread.lost_allocations.fetch_add(1, ::std::memory_order_relaxed);
+         return;
+      }
+
+      thread.ring[head & (Thread::RingSize - 1)] = event;
+      thread.ring_head.store(head + 1, ::std::memory_order_release);
+   }
+
+   /// The deferred mode's aggregator thread                                  
+   /// Keeps compiling recorded events, until the state is destroyed, and     
+   /// sleeps only after a pass that found nothing to compile                 
+   void State::Aggregate() {
+      ::std::vector<Thread*> pending;
+      while (aggregating.load(::std::memory_order_relaxed)) {
+         {
+            ::std::scoped_lock lock {threads_guard};
+            pending.clear();
+            for (auto& thread : threads)
+               pending.push_back(thread.get());
+         }
+
+         bool idle = true;
+         for (auto thread : pending) {
+            if (thread->ring_head.load(::std::memory_order_relaxed)
+             == thread->ring_tail.load(::std::memory_order_relaxed))
+               continue;
+
+            bool main_ended;
+            {
+               ::std::scoped_lock lock {thread->guard};
+               main_ended = Drain(*thread);
+            }
+            Closed(*thread, main_ended, timer.Now());
+            idle = false;
+         }
+
+         if (idle)
+            ::std::this_thread::sleep_for(1ms);
+      }
+   }
+
+   /// React on compiled measurements by writing results when it's time       
+   /// Must be called without holding any guards                              
+   ///   @param thread - the thread that compiled measurements                
+   ///   @param main_ended - whether the thread's master measurement ended    
+   ///   @param now - a recent timestamp, such as the measurement's end, so   
+   ///      that the clock isn't read again on each stop                      
+   void State::Closed(Thread& thread, bool main_ended, Ticks now) {
+      if (main_ended) {
+         // Once the main thread's master measurement stops, we dump    
+         // the results in a file. Workers' masters just get compiled   
+         if (thread.id == main_thread)
+            End();
+         return;
+      }
+
+      if (output_interval == 0s)
+         return;
+
+      // Only the thread that manages to advance the timestamp asks     
+      // for a dump, which is then written in the background            
+      auto last = last_output_timestamp.load(::std::memory_order_relaxed);
+      if (now > last and timer.ToTime(now - last) > output_interval
+      and last_output_timestamp.compare_exchange_strong(last, now))
+         RequestDump(now);
+   }
+
+   /// Ask the background writer to dump the results up until now, starting   
+   /// the writer on first request. Requests made while the writer is busy    
+   /// are coalesced into a single dump                                       
+   ///   @param now - the timestamp of the request                            
+   void State::RequestDump(Ticks now) {
+      {
+         ::std::scoped_lock lock {writer_guard};
+         if (writer_stopping)
+            return;
+         StartWriter();
+         if (not write_requested)
+            write_requested_at = now;
+         write_requested = true;
+      }
+      writer_signal.notify_one();
+   }
+
+   /// Start the background writer, if not started yet                        
+   /// The writer guard must be locked                                        
+   void State::StartWriter() {
+      if (not writer.joinable())
+         writer = ::std::thread {[this] { Write(); }};
+   }
+
+   /// The background writer thread                                           
+   /// Waits for dump requests, and streams the trace periodically, until     
+   /// the state is destroyed                                                 
+   void State::Write() {
+      const auto ready = [this] {
+         return write_requested or writer_stopping;
       };
-      return stack->child;
+
+      ::std::unique_lock lock {writer_guard};
+      while (true) {
+         if (tracing.load(::std::memory_order_relaxed))
+            writer_signal.wait_for(lock, TracePeriod, ready);
+         else {
+            // Also wake up when a trace gets started, to begin polling 
+            writer_signal.wait(lock, [&] {
+               return ready() or tracing.load(::std::memory_order_relaxed);
+            });
+         }
+         if (writer_stopping)
+            return;
+
+         const bool dump = write_requested;
+         const auto requested = write_requested_at;
+         write_requested = false;
+         lock.unlock();
+         if (dump)
+            DumpProfilerResults(requested);
+         FlushTrace();
+         lock.lock();
+      }
+   }
+
+   /// Start streaming a binary trace of all measurements into a file         
+   /// The trace is written in chunks by the background writer, and can be    
+   /// converted to reports offline, see Converter.cpp                        
+   ///   @param file - the file to stream into, gets overwritten              
+   ///   @return true if the trace was started                                
+   bool State::StartTrace(String&& file) {
+      {
+         ::std::scoped_lock lock {trace_guard};
+         if (trace_file.is_open()) {
+            Logger::Error("Profiler: a trace is already being written");
+            return false;
+         }
+
+         trace_file.open(file, ::std::ios::out | ::std::ios::binary | ::std::ios::trunc);
+         if (not trace_file.is_open()) {
+            Logger::Error("Can't open trace file: ", file);
+            return false;
+         }
+
+         trace_staging.clear();
+         Trace::PutVarint(trace_staging, Trace::Version);
+         trace_file.write(Trace::Magic, sizeof(Trace::Magic));
+         trace_file.write(reinterpret_cast<const char*>(trace_staging.data()), trace_staging.size());
+      }
+
+      {
+         ::std::scoped_lock lock {writer_guard};
+         StartWriter();
+         tracing = true;
+      }
+      writer_signal.notify_one();
+      return true;
+   }
+
+   /// Stream all trace events recorded since the last flush                  
+   /// Descriptors and builds are written before the first events that        
+   /// reference them                                                         
+   void State::FlushTrace() {
+      if (not tracing.load(::std::memory_order_relaxed))
+         return;
+
+      ::std::scoped_lock trace_lock {trace_guard};
+      ::std::vector<Thread*> pending;
+      {
+         // Take the events first, so that all the descriptors they     
+         // reference are already registered below                      
+         ::std::scoped_lock lock {threads_guard};
+         for (auto& thread : threads) {
+            ::std::scoped_lock thread_lock {thread->guard};
+            thread->trace.swap(thread->trace_spare);
+            pending.push_back(thread.get());
+         }
+      }
+
+      auto& out = trace_staging;
+      out.clear();
+      {
+         ::std::scoped_lock lock {descriptors_guard};
+         for (; trace_descriptors < descriptors.size(); ++trace_descriptors) {
+            const auto& d = descriptors[trace_descriptors];
+            if (trace_builds.insert(d.build).second) {
+               const auto& b = builds.at(d.build);
+               out.push_back(static_cast<uint8_t>(Trace::Record::Build));
+               Trace::PutVarint(out, d.build);
+               Trace::PutVarint(out, b.properties.to_ullong());
+               out.push_back(b.bitness);
+               out.push_back(b.alignment);
+               out.push_back(b.endianness);
+            }
+
+            out.push_back(static_cast<uint8_t>(Trace::Record::Descriptor));
+            Trace::PutVarint(out, d.id);
+            Trace::PutVarint(out, d.build);
+            Trace::PutVarint(out, d.line);
+            Trace::PutString(out, d.name);
+            Trace::PutString(out, d.file);
+         }
+      }
+
+      timer.Calibrate();
+      uint64_t bits;
+      const double ns_per_tick = timer.NsPerTick();
+      ::std::memcpy(&bits, &ns_per_tick, sizeof(bits));
+      out.push_back(static_cast<uint8_t>(Trace::Record::Clock));
+      for (unsigned i = 0; i < 8; ++i)
+         out.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+
+      for (auto thread : pending) {
+         auto& events = thread->trace_spare;
+         if (events.empty())
+            continue;
+
+         out.push_back(static_cast<uint8_t>(Trace::Record::Events));
+         Trace::PutVarint(out, (thread->index << 1) | (thread->id == main_thread));
+         Trace::PutVarint(out, events.size());
+         trace_file.write(reinterpret_cast<const char*>(out.data()), out.size());
+         trace_file.write(reinterpret_cast<const char*>(events.data()), events.size());
+         out.clear();
+         events.clear();
+      }
+
+      trace_file.write(reinterpret_cast<const char*>(out.data()), out.size());
+      trace_file.flush();
+   }
+
+   /// Throttle the measurement sites that cost too much to measure           
+   /// A site's distortion is the overhead of measuring an entry, relative to 
+   /// the site's average duration, pooled from everywhere it was called -    
+   /// that much time gets added to its callers on each measured entry.       
+   /// Sampling every Nth entry divides it by N, so the smallest N that fits  
+   /// the budget is picked, and sites that would need more than              
+   /// GovernorMaxPeriod are disabled. The periods only ever grow, and the    
+   /// dump guard must be locked                                              
+   void State::Govern() {
+      const auto budget = static_cast<double>(governor_budget.load(::std::memory_order_relaxed));
+      if (budget <= 0)
+         return;
+
+      struct Pool {
+         const Descriptor* descriptor = nullptr;
+         long long samples = 0;
+         double sum = 0;
+      };
+
+      ::std::vector<Pool> pools;
+      for (Node n = 0; n < results.Size(); ++n) {
+         const auto d = results.descriptor[n];
+         if (d->id >= pools.size())
+            pools.resize(d->id + 1);
+         pools[d->id].descriptor = d;
+         pools[d->id].samples += results.samples[n];
+         pools[d->id].sum += results.mean[n] * static_cast<double>(results.samples[n]);
+      }
+
+      if (throttles.size() < pools.size())
+         throttles.resize(pools.size());
+
+      const auto calibrated = overhead[static_cast<int>(mode.load())].outer;
+      const auto configured = governor_overhead.load(::std::memory_order_relaxed);
+      const auto per_entry = configured > 0s ? configured : timer.ToTime(calibrated);
+      const auto cost = static_cast<double>(::std::chrono::duration_cast<
+         ::std::chrono::nanoseconds>(per_entry).count());
+      for (size_t id = 0; id < pools.size(); ++id) {
+         const auto& pool = pools[id];
+         if (pool.samples < GovernorMinSamples or pool.sum <= 0)
+            continue;
+
+         const auto period = pool.descriptor->period.load(::std::memory_order_relaxed);
+         const auto distortion = cost * static_cast<double>(pool.samples) / pool.sum;
+         if (not period or distortion <= budget * period)
+            continue;
+
+         const auto needed = ::std::ceil(distortion / budget);
+         pool.descriptor->period.store(needed > GovernorMaxPeriod
+            ? 0 : static_cast<uint32_t>(needed), ::std::memory_order_relaxed);
+         throttles[id] = {pool.descriptor, distortion};
+      }
    }
 
    /// End all measurements, compile the results, and write file              
+   /// This is the final dump, so it is written on the spot                   
    void State::End() {
-      DumpProfilerResults();
+      DumpProfilerResults(timer.Now());
    }
 
    /// Dump the results into a text file                                      
-   ///   @param b - the build configuration (should be inline-generated)      
-   void State::DumpProfilerResults() const {
-      LANGULUS(PROFILE);
-      const auto now = ::std::chrono::system_clock::to_time_t(::std::chrono::system_clock::now());
+   /// Merges the results of all threads into a single snapshot first, and    
+   /// marks the report with how long after the request the snapshot was      
+   /// taken, and how long it took to render                                  
+   ///   @param requested - when the dump was requested                       
+   void State::DumpProfilerResults(Ticks requested) {
+      ::std::scoped_lock dump_lock {dump_guard};
+      results.Clear();
+      active_builds.clear();
+      ::std::vector<Node> map;
+      ::std::vector<Thread*> pending;
+      size_t lost_allocations = 0;
+      frames.clear();
+      {
+         ::std::scoped_lock lock {threads_guard};
+         for (auto& thread : threads)
+            pending.push_back(thread.get());
+      }
+
+      timer.Calibrate();
+      const auto snapshot = timer.Now();
+      ::std::vector<::std::pair<Node, Time>> running;
+      for (auto thread : pending) {
+         Frames* copy = nullptr;
+         running.clear();
+         {
+            // Compile anything the aggregator didn't get to yet, and   
+            // swap the results for the spare ones - they're merged     
+            // after the thread is released, so that it never waits     
+            // for a merge                                              
+            ::std::scoped_lock thread_lock {thread->guard};
+            Drain(*thread);
+            ::std::swap(thread->results, thread->results_spare);
+            thread->results.CopyTree(thread->results_spare);
+            active_builds.insert(
+               thread->active_builds.begin(),
+               thread->active_builds.end()
+            );
+
+            // Measurements that are still running contribute the time  
+            // elapsed until now - this is computed only here, instead  
+            // of refreshing every ancestor whenever a child stops      
+            for (auto m = thread->main; m; m = m->child)
+               running.emplace_back(m->compiled, timer.ToTime(snapshot - m->start));
+
+            // Copy the frame history, oldest first                     
+            if (const auto count = thread->frames.size()) {
+               copy = &frames.emplace_back(
+                  thread->index, thread->id == main_thread, thread->frame_count - count);
+               copy->frames.reserve(count);
+               for (size_t f = 0; f < count; ++f)
+                  copy->frames.emplace_back(thread->frames[(thread->frame_count + f) % count]);
+            }
+         }
+
+         // The thread keeps the same nodes in all of its databases, so 
+         // whatever refers to them maps to the snapshot the same way   
+         lost_allocations += thread->lost_allocations.load(::std::memory_order_relaxed);
+         thread->results_dumped.Merge(thread->results_spare, map);
+         thread->results_spare.Reset();
+         results.Merge(thread->results_dumped, map);
+         for (auto [n, elapsed] : running)
+            results.total[map[n]] += elapsed;
+         if (copy) {
+            for (auto& frame : copy->frames) {
+               for (auto& [n, total] : frame.scopes)
+                  n = map[n];
+            }
+         }
+      }
+
+      Govern();
+
+      // Take the profiler's own cost out of the totals, as calibrated  
+      // for the current mode                                           
+      const auto& cost = overhead[static_cast<int>(mode.load())];
+      results.Compensate(timer.ToTime(cost.inner), timer.ToTime(cost.outer));
+
+      const auto wall = ::std::chrono::system_clock::now();
+      const auto now = ::std::chrono::system_clock::to_time_t(wall);
       const auto timestamp = fmt::format("{:%F %T %Z}", fmt::localtime(now));
+      const auto delay = snapshot > requested
+         ? timer.ToTime(snapshot - requested) : Time::zero();
+      const auto render = timer.ToTime(timer.Now() - snapshot);
+      const auto epoch = ::std::chrono::duration_cast<::std::chrono::milliseconds>(
+         wall.time_since_epoch()).count();
+      const auto interval = ::std::chrono::duration_cast<::std::chrono::milliseconds>(
+         output_interval).count();
+
+      const auto heading = fmt::format(
+         "Last performance results: {} ({} threads, timed by {})",
+         timestamp, pending.size(), timer.UsesTSC() ? "TSC" : "steady_clock"
+      );
 
-      std::ofstream out;
+      // Mark how stale the report is - the age is updated live by the  
+      // viewer, and turns red once the report missed two refreshes     
+      ::std::ostringstream notes;
+      notes << "<div>- snapshot taken " << RealMs(delay)
+            << " ms after it was requested, and rendered in " << RealMs(render)
+            << " ms; <span id=\"age\"></span></div>\n";
+      notes << "<div>- profiler overhead per measured entry: "
+            << ::std::chrono::duration_cast<::std::chrono::nanoseconds>(timer.ToTime(cost.inner)).count()
+            << " ns within the scope, "
+            << ::std::chrono::duration_cast<::std::chrono::nanoseconds>(timer.ToTime(cost.outer)).count()
+            << " ns within its parent;</div>\n";
+      if (lost_allocations) {
+         notes << "<div>- <span style=\"background-color: OrangeRed;\">" << lost_allocations
+               << " allocations were lost</span>, because the aggregator couldn't keep up;</div>\n";
+      }
+      if (const auto missing = counters_missing.load(::std::memory_order_relaxed)) {
+         notes << "<div>- <span style=\"background-color: DarkGoldenRod;\">unavailable</span> counters:";
+         const char* separator = " ";
+         for (size_t c = 0; c < ::std::size(CounterNames); ++c) {
+            if (missing & Mask(static_cast<Counter>(c))) {
+               notes << separator << CounterNames[c];
+               separator = ", ";
+            }
+         }
+         notes << " - check perf_event_paranoid, or the virtual machine's PMU;</div>\n";
+      }
+      notes << "<script>\n";
+      notes << "   function age() {\n";
+      notes << "      const ms = Date.now() - " << epoch << ";\n";
+      notes << "      const e = document.getElementById(\"age\");\n";
+      notes << "      e.textContent = \"data is \" + (ms / 1000).toFixed(1) + \" s old\";\n";
+      notes << "      if (" << interval << " > 0 && ms > 2 * " << interval << ")\n";
+      notes << "         e.style.color = \"OrangeRed\";\n";
+      notes << "   }\n";
+      notes << "   age();\n";
+      notes << "   setInterval(age, 1000);\n";
+      notes << "</script>\n";
+
+      // List the sites the governor throttled, with how much of their  
+      // callers' time their instrumentation took before, and now       
+      for (auto& throttle : throttles) {
+         if (not throttle.descriptor)
+            continue;
+
+         const auto period = throttle.descriptor->period.load(::std::memory_order_relaxed);
+         notes << "<div>- <span style=\"background-color: DarkGoldenRod;\">throttled</span> "
+               << throttle.descriptor->name << " [BUILD: "
+               << fmt::format("{:016X}", throttle.descriptor->build) << "]: "
+               << "instrumentation was " << fmt::format("{:.1f}", throttle.distortion * 100)
+               << "% of its time, ";
+         if (period) {
+            notes << "now sampling every " << period << " entries, for "
+                  << fmt::format("{:.1f}", throttle.distortion * 100 / period) << "%</div>\n";
+         }
+         else
+            notes << "now disabled, its results are frozen</div>\n";
+      }
+
+      for (auto& history : frames)
+         WriteFrames(notes, results, history.thread, history.main, history.first, history.frames);
+
+      // Render the page in memory first, so that the file is truncated 
+      // only for as long as it takes to write it out                   
+      ::std::ostringstream page;
+      {
+         ::std::scoped_lock lock {descriptors_guard};
+         WriteHtml(page, {heading, notes.str(), results, active_builds, builds});
+      }
+
+      ::std::ofstream out;
       out.open(output_file, ::std::ios::out | ::std::ios::trunc);
       if (not out.is_open())
          Logger::Error("Can't open profiling file: ", output_file);
+      out << page.view();
+      out.close();
+
+      if (not folded_file.empty()) {
+         ::std::ostringstream stacks;
+         WriteFolded(stacks, results, folded_per_build);
+         out.open(folded_file, ::std::ios::out | ::std::ios::trunc);
+         if (not out.is_open())
+            Logger::Error("Can't open folded stacks file: ", folded_file);
+         out << stacks.view();
+         out.close();
+      }
+   }
 
+   /// Render a report as an HTML page                                        
+   ///   @param out - the stream to write to                                  
+   ///   @param report - the results and what to title them with              
+   void WriteHtml(::std::ostream& out, const Report& report) {
       out << "<!DOCTYPE html><html>\n";
       out << "<body style = \"color: LightGray; background-color: black; font-family: monospace; font-size: 14px; white-space: pre; \">\n";
       out << "<head><style>\n";
@@ -107,168 +1493,235 @@ namespace Langulus::Profiler
       out << "      line-height: 12px;\n";
       out << "   }\n";
       out << "</style></head>\n";
-      out << "<h2>Last performance results: " << timestamp << "</h2>\n";
+      out << "<h2>" << report.heading << "</h2>\n";
+      out << report.notes;
 
-      for (auto& r : results)
-         for (auto& r2 : r.second)
-            r2.second->Dump(out, nullptr);
+      for (auto r = report.results.Roots(); r != NoNode; r = report.results.sibling[r])
+         report.results.Dump(out, r, report.active_builds);
+
+      // Write a legend of all the builds that took part                
+      out << "<h2>Builds:</h2>\n";
+      for (auto& [id, build] : report.builds) {
+         out << "<div>" << fmt::format("{:016X}", id) << ": "
+             << int(build.bitness) << "-bit, "
+             << int(build.alignment) << "-byte aligned, "
+             << (build.endianness == 1 ? "big-endian"
+               : build.endianness == 2 ? "little-endian"
+               : "bi-endian");
+         for (size_t p = 0; p < Build::Property::Counter; ++p) {
+            if (build.properties[p])
+               out << ", " << Build::Names[p];
+         }
+         out << "</div>\n";
+      }
 
       out << "</body></html>";
-      out.close();
    }
 
-   /// Compile a measurement into the results                                 
-   ///   @param b - the measurement to compile                                
-   void State::Compile(Measurement* b) {
-      LANGULUS_ASSUME(DevAssumes, not b->child,
-         "A measurement (", b->name, ") still has a child running (", b->child->name,"), "
-         "they should be compiled first when they go out of scope! "
-         "Are they on different threads maybe?"
-      );
+   namespace
+   {
+      /// Write a result and its children as folded stacks                    
+      ///   @param out - the stream to write to                               
+      ///   @param stack - the folded frames of the ancestors, restored       
+      ///   @param results - the tree the result is in                        
+      ///   @param n - the result to write                                    
+      void WriteFolded(::std::ostream& out, String& stack, const Database& results, Node n) {
+         const auto size = stack.size();
+         if (size)
+            stack += ';';
 
-      if (not b->parent) {
-         // We're compiling the main measurement                        
-         auto& found_function = results[b->name];
-         auto& found_build = found_function[b->build];
-         if (found_build)
-            found_build->Integrate(*b);
-         else
-            found_build = ::std::make_unique<Result>(*b);
-
-         // Once it stops we dump the results in a file                 
-         active_builds.insert(b->build);
-         Instance.End();
-         main = nullptr;
-         return;
-      }
-
-      if (b->parent->compiled) {
-         // A result already exists, just integrate over it             
-         auto& found_function = b->parent->compiled->children[b->name];
-         auto& found_build = found_function[b->build];
-         if (found_build)
-            found_build->Integrate(*b);
-         else
-            found_build = ::std::make_unique<Result>(*b);
+         // Frames can't contain the separators of the folded format    
+         for (const char c : results.descriptor[n]->name)
+            stack += c == ';' ? ':' : c == '\n' ? ' ' : c;
 
-         if (b->ended) {
-            // A child has been compiled                                
-            active_builds.insert(b->build);
-            b->parent->child = nullptr;
-         }
-         else b->compiled = found_build.get();
+         // Self time is whatever the children didn't consume           
+         auto self = results.total[n];
+         for (auto c = results.child[n]; c != NoNode; c = results.sibling[c])
+            self -= results.total[c];
 
-         // We still have to climb and update total time for running    
-         // results                                                     
-         auto p = b->parent;
-         while (p and not p->ended) {
-            p->compiled->Integrate(*p);
-            p = p->parent;
-         }
-      }
-      else {
-         // We have to build the result hierarchy from the ground up    
-         // and cache it so we don't have to do it again                
-         auto node = main;
-         while (node) {
-            if (not node->compiled) {
-               auto& found_function = node->parent
-                  ? node->parent->compiled->children[node->name]
-                  : results[node->name];
-               auto& found_build = found_function[node->build];
-               if (found_build)
-                  found_build->Integrate(*node);
-               else
-                  found_build = ::std::make_unique<Result>(*node);
-
-               if (node->parent and node->ended) {
-                  // A measurement has been compiled                    
-                  active_builds.insert(node->build);
-                  node->parent->child = nullptr;
-                  break;
-               }
-               
-               node->compiled = found_build.get();
-            }
+         const auto ns = ::std::chrono::duration_cast<::std::chrono::nanoseconds>(self).count();
+         if (ns > 0)
+            out << stack << ' ' << ns << '\n';
 
-            node = node->child;
-         }
+         for (auto c = results.child[n]; c != NoNode; c = results.sibling[c])
+            WriteFolded(out, stack, results, c);
+         stack.resize(size);
       }
+   }
 
-      if (output_interval != 0s and Clock::now() > last_output_timestamp + output_interval) {
-         // Time to dump the results up until now                       
-         last_output_timestamp = Clock::now();
-         DumpProfilerResults();
+   /// Render results as Brendan Gregg's folded stacks, one line per call     
+   /// path, followed by the self time of its last frame in nanoseconds -     
+   /// ready for flamegraph.pl, speedscope, and the like                      
+   ///   @param out - the stream to write to                                  
+   ///   @param results - the results to render                               
+   ///   @param per_build - whether to root each stack in its build, so that  
+   ///      every build gets its own tower in the flamegraph                  
+   void WriteFolded(::std::ostream& out, const Database& results, bool per_build) {
+      String stack;
+      for (auto r = results.Roots(); r != NoNode; r = results.sibling[r]) {
+         stack.clear();
+         if (per_build)
+            stack = fmt::format("{:016X}", results.descriptor[r]->build);
+         WriteFolded(out, stack, results, r);
       }
    }
 
-   State::Measurement::Measurement(String&& n, Build&& b, Measurement* p) noexcept
-      : name   {::std::forward<String>(n)}
-      , build  {::std::forward<Build>(b)}
-      , start  {Clock::now()}
-      , end    {start}
-      , parent {p} {
+   State::Measurement::Measurement(const Descriptor& d, Measurement* p, Node r, uint32_t w) noexcept
+      : descriptor {&d}
+      , start      {0}
+      , end        {0}
+      , parent     {p}
+      , compiled   {r}
+      , weight     {w} {
       LANGULUS_ASSUME(DevAssumes, not parent or not parent->child,
          "A parent already has a child"
       );
    }
 
-   void State::Measurement::Stop() noexcept {
-      end = Clock::now();
-      ended = true;
-      Instance.Compile(this);
+   /// Compile the duration of a finished measurement into a result           
+   /// Running measurements are accounted for only when dumping               
+   ///   @param n - the result                                                
+   ///   @param duration - the duration of the measurement                    
+   ///   @param weight - how many entries the measurement stands for, the     
+   ///      per-call statistics count it once, the totals count it weight     
+   ///      times                                                             
+   void Database::Integrate(Node n, Time duration, uint32_t weight) {
+      const auto count = ::std::chrono::duration_cast<::std::chrono::nanoseconds>(duration).count();
+      const auto ns = static_cast<double>(count);
+      histogram[n].Add(count > 0 ? static_cast<uint64_t>(count) : 0);
+
+      const auto s = ++samples[n];
+      const auto delta = ns - mean[n];
+      mean[n] += delta / static_cast<double>(s);
+      m2[n] += delta * (ns - mean[n]);
+      total[n] += duration * weight;
+      calls[n] += weight;
+
+      if (duration < min[n])
+         min[n] = duration;
+      if (duration > max[n])
+         max[n] = duration;
    }
 
-   /// Compile a measurement into a Result                                    
-   ///   @param m - the measurement to compile                                
-   State::Result::Result(const Measurement& m) {
-      name = m.name;
-      build = m.build;
+   /// Count recursive entries that were folded into a result                 
+   ///   @param n - the result                                                
+   ///   @param entries - how many entries were folded                        
+   ///   @param depth - the deepest recursion among them                      
+   void Database::Fold(Node n, uint32_t entries, uint32_t depth) noexcept {
+      recursions[n] += entries;
+      if (depth > deepest[n])
+         deepest[n] = depth;
+   }
 
-      if (m.ended) {
-         const auto duration = m.end - m.start;
-         min = max = average = total = duration;
-         samples = 1;
-      }
-      else total = Clock::now() - m.start;
+   /// Account for work counted by a finished measurement                     
+   ///   @param n - the result                                                
+   ///   @param unit - what was counted                                       
+   ///   @param amount - how much work the measurement did                    
+   ///   @param duration - the duration of the measurement                    
+   ///   @param weight - how many entries the measurement stands for          
+   void Database::Account(Node n, Unit unit, uint64_t amount, Time duration, uint32_t weight) noexcept {
+      (unit == Unit::Bytes ? bytes : items)[n].Add(amount, duration, weight);
    }
 
-   /// Compile a measurement into an already existing Result                  
-   ///   @param m - the measurement to compile                                
-   void State::Result::Integrate(const Measurement& m) {
-      if (not m.ended) {
-         if (samples == 0)
-            total = Clock::now() - m.start;
+   /// Add the work of a single call                                          
+   /// The throughput of the call is taken as is, while the amount and the    
+   /// time are counted weight times, like totals are                         
+   ///   @param work - how much work the call did                             
+   ///   @param duration - the duration of the call                           
+   ///   @param weight - how many calls the call stands for                   
+   void Throughput::Add(uint64_t work, Time duration, uint32_t weight) noexcept {
+      const auto s = ::std::chrono::duration<double>(duration).count();
+      amount += work * weight;
+      seconds += s * weight;
+      if (s <= 0)
          return;
-      }
 
-      const auto duration = m.end - m.start;
-      if (samples == 0) {
-         // First measurement                                           
-         min = max = average = total = duration;
-         samples = 1;
-      }
-      else {
-         // Consecutive measurements (averaging a sample)               
-         ++samples;
-         average = (((samples - 1) * average) + duration) / samples;
-         total += duration;
+      const auto rate = static_cast<double>(work) / s;
+      slowest = ::std::min(slowest, rate);
+      fastest = ::std::max(fastest, rate);
+   }
 
-         if (duration < min)
-            min = duration;
-         if (duration > max)
-            max = duration;
-      }
+   /// Add the allocations of a single call                                   
+   ///   @param call - the allocations of the call                            
+   ///   @param weight - how many calls the call stands for                   
+   void Allocations::Add(const Allocations& call, uint32_t weight) noexcept {
+      count += call.count * weight;
+      bytes += call.bytes * weight;
+      peak = ::std::max(peak, call.peak);
+   }
+
+   /// Add up the allocations of another result                               
+   ///   @param other - the allocations to merge                              
+   void Allocations::Merge(const Allocations& other) noexcept {
+      count += other.count;
+      bytes += other.bytes;
+      peak = ::std::max(peak, other.peak);
+   }
+
+   /// Add up the work of another result                                      
+   ///   @param other - the throughput to merge                               
+   void Throughput::Merge(const Throughput& other) noexcept {
+      amount += other.amount;
+      seconds += other.seconds;
+      slowest = ::std::min(slowest, other.slowest);
+      fastest = ::std::max(fastest, other.fastest);
+   }
+
+   /// Get the average duration of a result's samples                         
+   ///   @param n - the result                                                
+   ///   @return the average                                                  
+   Time Database::Average(Node n) const noexcept {
+      return ::std::chrono::duration_cast<Time>(
+         ::std::chrono::duration<double, ::std::nano>(mean[n]));
+   }
+
+   /// Get the standard deviation of a result's samples                       
+   ///   @param n - the result                                                
+   ///   @return the sample standard deviation, zero if under two samples     
+   Time Database::Deviation(Node n) const noexcept {
+      if (samples[n] < 2)
+         return Time::zero();
+      const auto variance = m2[n] / static_cast<double>(samples[n] - 1);
+      return ::std::chrono::duration_cast<Time>(
+         ::std::chrono::duration<double, ::std::nano>(::std::sqrt(variance)));
+   }
+
+   /// Get a percentile of a result's samples, such as 0.99 for p99           
+   /// The value is precise to within 1/16th of itself                        
+   ///   @param n - the result                                                
+   ///   @param q - the portion of samples that are faster                    
+   ///   @return the duration                                                 
+   Time Database::Percentile(Node n, double q) const noexcept {
+      if (not samples[n])
+         return Time::zero();
+
+      const auto t = ::std::chrono::duration_cast<Time>(
+         ::std::chrono::nanoseconds(histogram[n].Percentile(q)));
+      return ::std::clamp(t, min[n], max[n]);
+   }
+
+   /// Get the coefficient of variation, telling jitter apart from changes    
+   /// in the average - it stays about the same for a scope, unless the       
+   /// scope's behavior changes                                               
+   ///   @param n - the result                                                
+   ///   @return the standard deviation relative to the mean                  
+   Real Database::Variation(Node n) const noexcept {
+      if (samples[n] < 2 or mean[n] <= 0)
+         return 0;
+      return static_cast<Real>(::std::sqrt(m2[n] / static_cast<double>(samples[n] - 1)) / mean[n]);
    }
-   
-   /// Write a result as HTML                                                 
+
+   /// Write a result and its children as HTML                                
    ///   @param out - file to write to                                        
-   ///   @param parent - parent result for contextualizing data               
-   void State::Result::Dump(::std::ofstream& out, const Result* parent) const {
+   ///   @param n - the result to write                                       
+   ///   @param active - builds that were measured since the last dump        
+   void Database::Dump(::std::ostream& out, Node n, const ::std::unordered_set<BuildID>& active) const {
       // Write name and build                                           
-      const Real hot = parent ? RealMs(total) / RealMs(parent->total) : 1_real;
-      const auto hex = Logger::Hex(build);
-      const bool act = Instance.active_builds.contains(build) and hot > 0.25_real;
+      const auto p = parent[n];
+      const Real hot = p != NoNode ? RealMs(total[n]) / RealMs(total[p]) : 1_real;
+      const auto& name = descriptor[n]->name;
+      const auto hex = fmt::format("{:016X}", descriptor[n]->build);
+      const bool act = active.contains(descriptor[n]->build) and hot > 0.25_real;
 
       // Color-code hot results:                                        
       //    -> blue if relative_hotness goes to zero                    
@@ -277,7 +1730,7 @@ namespace Langulus::Profiler
       int red = 255;
       int green = 255;
       int blue = 255;
-      if (parent) {
+      if (p != NoNode) {
          const Real relative_hotness = std::max(std::min(hot, 1_real), 0_real);
          if (relative_hotness < 0.5f)
             red = green = 128 + static_cast<int>((relative_hotness * 2_real) * 128_real);
@@ -288,24 +1741,24 @@ namespace Langulus::Profiler
       // Write the measurement heading                                  
       if (act) {
          out << "<details open style=\"color:rgb("<<red<<","<<green<<","<<blue<<");\"><summary><h3>" << name
-             << " [BUILD: " << std::string(std::begin(hex), std::end(hex)) << "]</h3></summary>\n";
+             << " [BUILD: " << hex << "]</h3></summary>\n";
       }
       else {
          out << "<details      style=\"color:rgb("<<red<<","<<green<<","<<blue<<");\"><summary><h3>" << name
-             << " [BUILD: " << std::string(std::begin(hex), std::end(hex)) << "]</h3></summary>\n";
+             << " [BUILD: " << hex << "]</h3></summary>\n";
       }
 
       // Write how often the function gets called in its parent         
-      if (parent and parent->samples) {
-         if (samples != parent->samples) {
-            if (parent->samples < samples) {
+      if (p != NoNode and calls[p]) {
+         if (calls[n] != calls[p]) {
+            if (calls[p] < calls[n]) {
                // The execution happens multiple times per parent call  
-               out << "<div>- happens about " << (samples / parent->samples)
+               out << "<div>- happens about " << (calls[n] / calls[p])
                    << " times per parent call</div>\n";
             }
             else {
                // The execution happens less often than the parent call 
-               int howOften = int((float(samples) / float(parent->samples)) * 100.0f);
+               int howOften = int((float(calls[n]) / float(calls[p])) * 100.0f);
                out << "<div>- has " << howOften
                    << "% chance to be called from parent</div>\n";
             }
@@ -317,35 +1770,358 @@ namespace Langulus::Profiler
       }
 
       // Write time stats                                               
-      if (samples > 1) {
-         out << "<div>- min time per call: " << RealMs(min)     << " ms;</div>\n";
-         out << "<div>- avg time per call: " << RealMs(average) << " ms;</div>\n";
-         out << "<div>- max time per call: " << RealMs(max)     << " ms;</div>\n";
-         out << "<div>- " << samples << " executions, for total time: " << RealMs(total) << " ms;</div>\n";
+      if (samples[n] > 1) {
+         out << "<div>- min time per call: " << RealMs(min[n])     << " ms;</div>\n";
+         out << "<div>- avg time per call: " << RealMs(Average(n)) << " ms;</div>\n";
+         out << "<div>- max time per call: " << RealMs(max[n])     << " ms;</div>\n";
+         out << "<div>- std deviation: " << RealMs(Deviation(n)) << " ms ("
+             << int(Variation(n) * 100_real) << "% of avg);</div>\n";
+         out << "<div>- percentiles: p50 " << RealMs(Percentile(n, 0.5))
+             << " ms, p90 "   << RealMs(Percentile(n, 0.9))
+             << " ms, p99 "   << RealMs(Percentile(n, 0.99))
+             << " ms, p99.9 " << RealMs(Percentile(n, 0.999)) << " ms;</div>\n";
       }
-      else if (samples == 1) {
-         out << "<div>- 1 execution, for total time: " << RealMs(total) << " ms;</div>\n";
+
+      if (samples[n]) {
+         out << "<div>- " << calls[n] << (calls[n] == 1 ? " execution" : " executions");
+         if (calls[n] != samples[n]) {
+            // Sampled, so the calls and the total are extrapolated     
+            out << " <span style=\"background-color: DarkGoldenRod;\">estimated</span> from "
+                << samples[n] << " samples";
+         }
+         out << ", for total time: " << RealMs(total[n]) << " ms;</div>\n";
       }
       else {
-         out << "<div>- <span style=\"background-color: ForestGreen;\">still running...</span> total time until now: " << RealMs(total) << " ms;</div>\n";
+         out << "<div>- <span style=\"background-color: ForestGreen;\">still running...</span> total time until now: " << RealMs(total[n]) << " ms;</div>\n";
+      }
+
+      // Write throughput stats                                         
+      for (auto [work, unit] : {::std::pair {&items[n], "items"}, {&bytes[n], "B"}}) {
+         if (not work->amount)
+            continue;
+
+         out << "<div>- throughput: " << Scaled(work->Average(), unit) << "/s avg";
+         if (samples[n] > 1 and work->fastest > 0) {
+            out << " (" << Scaled(work->slowest, unit) << "/s min, "
+                << Scaled(work->fastest, unit) << "/s max per call)";
+         }
+         out << ", " << Scaled(static_cast<double>(work->amount), unit) << " in total;</div>\n";
+      }
+
+      // Write allocation stats, where the ones done directly are       
+      // whatever the children didn't do                                
+      if (allocations[n].count) {
+         auto own_count = allocations[n].count;
+         auto own_bytes = allocations[n].bytes;
+         for (auto c = child[n]; c != NoNode; c = sibling[c]) {
+            own_count -= ::std::min(own_count, allocations[c].count);
+            own_bytes -= ::std::min(own_bytes, allocations[c].bytes);
+         }
+
+         out << "<div>- allocates " << allocations[n].count << " times, "
+             << Scaled(static_cast<double>(allocations[n].bytes), "B") << " in total ("
+             << own_count << " times, " << Scaled(static_cast<double>(own_bytes), "B")
+             << " directly), up to " << Scaled(static_cast<double>(allocations[n].peak), "B")
+             << " live per call;</div>\n";
+      }
+
+      // Write counter stats per call, and the rates derived from them  
+      const auto& k = counters[n];
+      if (calls[n] and ::std::ranges::any_of(k, [](uint64_t v) { return v != 0; })) {
+         const auto per_call = [&](Counter c) {
+            return static_cast<double>(k[static_cast<size_t>(c)]) / static_cast<double>(calls[n]);
+         };
+
+         out << "<div>- per call:";
+         const char* separator = " ";
+         for (size_t c = 0; c < k.size(); ++c) {
+            if (not k[c])
+               continue;
+            out << separator << Scaled(per_call(static_cast<Counter>(c)), "")
+                << CounterNames[c];
+            separator = ", ";
+         }
+         out << ";</div>\n";
+
+         const auto cycles = per_call(Counter::Cycles);
+         const auto instructions = per_call(Counter::Instructions);
+         if (cycles and instructions) {
+            out << "<div>- " << fmt::format("{:.2f}", instructions / cycles)
+                << " instructions per cycle";
+            for (auto c : {Counter::CacheMisses, Counter::BranchMisses}) {
+               if (const auto misses = per_call(c)) {
+                  out << ", " << fmt::format("{:.2f}", misses * 1000 / instructions)
+                      << ' ' << CounterNames[static_cast<size_t>(c)] << " per 1k instructions";
+               }
+            }
+            out << ";</div>\n";
+         }
+      }
+
+      // Write recursion stats                                          
+      if (recursions[n]) {
+         out << "<div>- recursed " << recursions[n]
+             << " more times, up to " << deepest[n] << " levels deep;</div>\n";
+      }
+
+      // Self time is whatever the children didn't consume, and the     
+      // compensated times are without the profiler's own cost - the    
+      // extrapolated totals of sampled children can exceed their       
+      // parent's, so they're clamped                                   
+      auto self = total[n];
+      auto self_overhead = overhead[n];
+      for (auto c = child[n]; c != NoNode; c = sibling[c]) {
+         self -= total[c];
+         self_overhead -= overhead[c];
+      }
+
+      out << "<div>- self time: " << RealMs(::std::max(self, Time::zero())) << " ms;</div>\n";
+      if (overhead[n] > Time::zero()) {
+         const auto clean = ::std::max(total[n] - overhead[n], Time::zero());
+         const auto clean_self = ::std::clamp(self - self_overhead, Time::zero(), clean);
+         out << "<div>- without profiler overhead of " << RealMs(overhead[n])
+             << " ms: total time " << RealMs(clean)
+             << " ms, self time " << RealMs(clean_self) << " ms;</div>\n";
       }
 
       // Write time usage portion                                       
-      if (parent) {
-         auto portion = RealMs(total) / RealMs(parent->total);
+      if (p != NoNode) {
+         auto portion = RealMs(total[n]) / RealMs(total[p]);
          out << "<div>- consumes " << int(portion * 100.0f)
                << "% of the parent function total time </div>\n";
       }
 
       // Do the same for sub-measurements                               
-      if (not children.empty()) {
+      if (child[n] != NoNode) {
          out << "<div>of which:</div>\n";
-         for (auto& cccc : children)
-            for (auto& child : cccc.second)
-               child.second->Dump(out, this);
+         for (auto c = child[n]; c != NoNode; c = sibling[c])
+            Dump(out, c, active);
       }
 
       out << "</details>\n";
    }
 
+   /// Find a result by its parent and measurement site, creating it if       
+   /// it doesn't exist yet                                                   
+   ///   @param parent - the parent node, or NoNode for a top-level result    
+   ///   @param d - the measurement site                                      
+   ///   @return the node                                                     
+   auto Database::Child(Node parent, const Descriptor& d) -> Node {
+      // Keep the table at most half full, so that probes stay short    
+      if ((Size() + 1) * 2 > table.size())
+         Rehash();
+
+      const auto mask = table.size() - 1;
+      auto i = HashNode(parent, d.id) & mask;
+      for (; table[i] != NoNode; i = (i + 1) & mask) {
+         const auto n = table[i];
+         if (this->parent[n] == parent and descriptor[n]->id == d.id)
+            return n;
+      }
+
+      // New results are prepended to their siblings                    
+      const auto n = static_cast<Node>(Size());
+      descriptor.push_back(&d);
+      this->parent.push_back(parent);
+      child.push_back(NoNode);
+      auto& first = parent != NoNode ? child[parent] : first_root;
+      sibling.push_back(first);
+      min.push_back(Time::max());
+      max.push_back(Time::min());
+      total.push_back(Time::zero());
+      samples.push_back(0);
+      calls.push_back(0);
+      mean.push_back(0);
+      m2.push_back(0);
+      histogram.emplace_back();
+      items.emplace_back();
+      bytes.emplace_back();
+      allocations.emplace_back();
+      recursions.push_back(0);
+      deepest.push_back(0);
+      counters.push_back({});
+      overhead.push_back(Time::zero());
+      first = n;
+      table[i] = n;
+      return n;
+   }
+
+   /// Double the size of the table, and reinsert all results                 
+   void Database::Rehash() {
+      table.assign(table.empty() ? 64 : table.size() * 2, NoNode);
+      const auto mask = table.size() - 1;
+      for (Node n = 0; n < Size(); ++n) {
+         auto i = HashNode(parent[n], descriptor[n]->id) & mask;
+         while (table[i] != NoNode)
+            i = (i + 1) & mask;
+         table[i] = n;
+      }
+   }
+
+   /// Merge another tree into this one                                       
+   /// Parents always precede their children, so a single pass resolves       
+   /// the structure, and each statistic is then merged in its own pass       
+   /// over its column. Merging into an empty tree just copies the columns    
+   ///   @param other - the tree to merge                                     
+   ///   @param map - [out] the node in this tree of each node in the other   
+   void Database::Merge(const Database& other, ::std::vector<Node>& map) {
+      map.resize(other.Size());
+      if (Empty()) {
+         *this = other;
+         ::std::iota(map.begin(), map.end(), Node {0});
+         return;
+      }
+
+      for (Node n = 0; n < other.Size(); ++n) {
+         const auto p = other.parent[n];
+         map[n] = Child(p != NoNode ? map[p] : NoNode, *other.descriptor[n]);
+      }
+
+      const auto count = other.Size();
+      for (size_t n = 0; n < count; ++n)
+         min[map[n]] = ::std::min(min[map[n]], other.min[n]);
+      for (size_t n = 0; n < count; ++n)
+         max[map[n]] = ::std::max(max[map[n]], other.max[n]);
+      for (size_t n = 0; n < count; ++n)
+         total[map[n]] += other.total[n];
+      for (size_t n = 0; n < count; ++n)
+         calls[map[n]] += other.calls[n];
+      for (size_t n = 0; n < count; ++n)
+         histogram[map[n]].Merge(other.histogram[n]);
+      for (size_t n = 0; n < count; ++n)
+         items[map[n]].Merge(other.items[n]);
+      for (size_t n = 0; n < count; ++n)
+         bytes[map[n]].Merge(other.bytes[n]);
+      for (size_t n = 0; n < count; ++n)
+         allocations[map[n]].Merge(other.allocations[n]);
+      for (size_t n = 0; n < count; ++n)
+         recursions[map[n]] += other.recursions[n];
+      for (size_t n = 0; n < count; ++n)
+         deepest[map[n]] = ::std::max(deepest[map[n]], other.deepest[n]);
+      for (size_t n = 0; n < count; ++n) {
+         for (size_t c = 0; c < other.counters[n].size(); ++c)
+            counters[map[n]][c] += other.counters[n][c];
+      }
+
+      // Means and deviations are combined with Chan's parallel algorithm
+      for (size_t n = 0; n < count; ++n) {
+         if (not other.samples[n])
+            continue;
+
+         const auto to = map[n];
+         const auto a = static_cast<double>(samples[to]);
+         const auto b = static_cast<double>(other.samples[n]);
+         const auto delta = other.mean[n] - mean[to];
+         mean[to] += delta * b / (a + b);
+         m2[to] += other.m2[n] + delta * delta * a * b / (a + b);
+         samples[to] += other.samples[n];
+      }
+   }
+
+   /// Estimate how much of each total is the profiler's own cost             
+   /// Each measured entry of a result adds the inner cost to its own         
+   /// duration, and the outer cost to the durations of all its ancestors.    
+   /// Children come after their parents, so a single reverse pass sums up    
+   /// the costs of the whole subtree. Costs are counted per call, so that    
+   /// results that are sampled get theirs extrapolated the same way their    
+   /// totals are, and each parent includes exactly the cost that's reported  
+   /// for its children                                                       
+   ///   @param inner - cost of an entry within its own duration              
+   ///   @param outer - cost of an entry within its parent's duration         
+   void Database::Compensate(Time inner, Time outer) {
+      const auto in = ::std::chrono::duration<double, ::std::nano>(inner).count();
+      const auto out = ::std::chrono::duration<double, ::std::nano>(outer).count();
+
+      // The cost included in each result's total                       
+      ::std::vector<double> within(Size(), 0.0);
+      for (auto n = static_cast<Node>(Size()); n-- > 0;) {
+         const auto c = static_cast<double>(calls[n]);
+         within[n] += in * c;
+         overhead[n] = ::std::chrono::duration_cast<Time>(
+            ::std::chrono::duration<double, ::std::nano>(within[n]));
+
+         if (parent[n] != NoNode)
+            within[parent[n]] += within[n] + (out - in) * c;
+      }
+   }
+
+   /// Take the tree of another database, grown from this one's, so that the  
+   /// same nodes stand for the same results in both. Nodes that are new get  
+   /// no statistics, and the ones already here keep theirs, so this costs    
+   /// only as much as the tree, no matter how large the statistics are       
+   ///   @param other - the database whose tree extends this one's            
+   void Database::CopyTree(const Database& other) {
+      LANGULUS_ASSUME(DevAssumes, Size() <= other.Size(),
+         "Copying a tree that doesn't extend this one"
+      );
+
+      descriptor = other.descriptor;
+      parent = other.parent;
+      child = other.child;
+      sibling = other.sibling;
+      table = other.table;
+      first_root = other.first_root;
+
+      const auto count = other.Size();
+      min.resize(count, Time::max());
+      max.resize(count, Time::min());
+      total.resize(count, Time::zero());
+      samples.resize(count, 0);
+      calls.resize(count, 0);
+      mean.resize(count, 0);
+      m2.resize(count, 0);
+      histogram.resize(count);
+      items.resize(count);
+      bytes.resize(count);
+      allocations.resize(count);
+      recursions.resize(count, 0);
+      deepest.resize(count, 0);
+      counters.resize(count);
+      overhead.resize(count, Time::zero());
+   }
+
+   /// Clear all statistics, keeping the tree                                 
+   void Database::Reset() noexcept {
+      ::std::ranges::fill(min, Time::max());
+      ::std::ranges::fill(max, Time::min());
+      ::std::ranges::fill(total, Time::zero());
+      ::std::ranges::fill(samples, 0);
+      ::std::ranges::fill(calls, 0);
+      ::std::ranges::fill(mean, 0);
+      ::std::ranges::fill(m2, 0);
+      ::std::ranges::fill(histogram, Histogram {});
+      ::std::ranges::fill(items, Throughput {});
+      ::std::ranges::fill(bytes, Throughput {});
+      ::std::ranges::fill(allocations, Allocations {});
+      ::std::ranges::fill(recursions, 0);
+      ::std::ranges::fill(deepest, 0);
+      ::std::ranges::fill(counters, CounterValues {});
+      ::std::ranges::fill(overhead, Time::zero());
+   }
+
+   /// Remove all results                                                     
+   void Database::Clear() noexcept {
+      descriptor.clear();
+      parent.clear();
+      child.clear();
+      sibling.clear();
+      min.clear();
+      max.clear();
+      total.clear();
+      samples.clear();
+      calls.clear();
+      mean.clear();
+      m2.clear();
+      histogram.clear();
+      items.clear();
+      bytes.clear();
+      allocations.clear();
+      recursions.clear();
+      deepest.clear();
+      counters.clear();
+      overhead.clear();
+      table.clear();
+      first_root = NoNode;
+   }
+
 } // namespace Langulus::Profiler
@@ -0,0 +1,81 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#include <Langulus/Profiler.hpp>
+
+#if LANGULUS_PROFILER_HAS_TSC() and not LANGULUS_COMPILER_MSVC()
+   #include <cpuid.h>
+#endif
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be built at all if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+
+namespace Langulus::Profiler
+{
+
+   namespace
+   {
+      /// Check if the CPU has an invariant TSC, that ticks at a constant     
+      /// rate regardless of power states - hypervisors often hide it         
+      ///   @return true if the TSC can be used as a timestamp source         
+      bool HasInvariantTSC() noexcept {
+         #if LANGULUS_PROFILER_HAS_TSC()
+            unsigned regs[4] {};
+            #if LANGULUS_COMPILER_MSVC()
+               __cpuid(reinterpret_cast<int*>(regs), 0x80000000);
+               if (regs[0] < 0x80000007)
+                  return false;
+               __cpuid(reinterpret_cast<int*>(regs), 0x80000007);
+            #else
+               if (not __get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]))
+                  return false;
+            #endif
+            return (regs[3] & (1u << 8)) != 0;
+         #else
+            return false;
+         #endif
+      }
+   }
+
+
+   /// Detect the timestamp source, and do the initial calibration            
+   Timer::Timer() noexcept {
+      anchor_time = ::std::chrono::steady_clock::now();
+      if (not HasInvariantTSC())
+         return;
+
+      // Spin for a couple of milliseconds to get an initial rate - it  
+      // gets refined by each Calibrate() as the baseline grows         
+      tsc = true;
+      anchor_ticks = Now();
+      while (::std::chrono::steady_clock::now() - anchor_time < ::std::chrono::milliseconds(2))
+         ;
+      Calibrate();
+
+      if (ns_per_tick.load() <= 0.0) {
+         Logger::Warning("Profiler: TSC calibration failed, falling back to steady_clock");
+         tsc = false;
+      }
+   }
+
+   /// Recalibrate the TSC rate against steady_clock                          
+   /// Uses the whole time since startup as a baseline, so the precision      
+   /// improves with each call. Does nothing if the TSC isn't used            
+   void Timer::Calibrate() noexcept {
+      if (not tsc)
+         return;
+
+      const auto ticks = Now() - anchor_ticks;
+      const auto time = ::std::chrono::duration<double, ::std::nano>(
+         ::std::chrono::steady_clock::now() - anchor_time).count();
+      if (ticks)
+         ns_per_tick.store(time / static_cast<double>(ticks), ::std::memory_order_relaxed);
+   }
+
+} // namespace Langulus::Profiler
@@ -0,0 +1,92 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#pragma once
+#include <Langulus/Core/Config.hpp>
+#include <chrono>
+#include <atomic>
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be included if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+#if defined(LANGULUS_PROFILER_TSC) and (defined(__x86_64__) or defined(_M_X64) or defined(__i386__) or defined(_M_IX86))
+   #define LANGULUS_PROFILER_HAS_TSC() 1
+   #if LANGULUS_COMPILER_MSVC()
+      #include <intrin.h>
+   #else
+      #include <x86intrin.h>
+   #endif
+#else
+   #define LANGULUS_PROFILER_HAS_TSC() 0
+#endif
+
+namespace Langulus::Profiler
+{
+
+   /// A raw timestamp, in whatever units the timestamp source uses           
+   using Ticks = ::std::uint64_t;
+
+   ///                                                                        
+   /// The timestamp source                                                   
+   /// Reads the invariant TSC when built with LANGULUS_PROFILER_TSC, and     
+   /// falls back to steady_clock nanoseconds when the CPU can't guarantee    
+   /// a constant-rate TSC. Raw ticks are converted to time only when         
+   /// aggregating or reporting                                               
+   ///                                                                        
+   struct Timer {
+   private:
+      bool tsc = false;
+      ::std::atomic<double> ns_per_tick = 1.0;
+      Ticks anchor_ticks = 0;
+      ::std::chrono::steady_clock::time_point anchor_time;
+
+   public:
+      LANGULUS_API(PROFILER) Timer() noexcept;
+      LANGULUS_API(PROFILER) void Calibrate() noexcept;
+
+      /// Check if the TSC is used as the timestamp source                    
+      ///   @return true if reading the TSC                                   
+      bool UsesTSC() const noexcept {
+         return tsc;
+      }
+
+      /// Get the current rate of the timestamp source                        
+      ///   @return nanoseconds per tick                                      
+      double NsPerTick() const noexcept {
+         return tsc ? ns_per_tick.load(::std::memory_order_relaxed) : 1.0;
+      }
+
+      /// Read a timestamp                                                    
+      ///   @return the raw timestamp                                         
+      LANGULUS(ALWAYS_INLINED)
+      Ticks Now() const noexcept {
+         #if LANGULUS_PROFILER_HAS_TSC()
+            if (tsc)
+               return __rdtsc();
+         #endif
+         return static_cast<Ticks>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(
+            ::std::chrono::steady_clock::now().time_since_epoch()).count());
+      }
+
+      /// Convert a difference between timestamps to time                     
+      ///   @param t - the raw duration                                       
+      ///   @return the duration                                              
+      LANGULUS(ALWAYS_INLINED)
+      auto ToTime(Ticks t) const noexcept -> ::std::chrono::steady_clock::duration {
+         using Duration = ::std::chrono::steady_clock::duration;
+         #if LANGULUS_PROFILER_HAS_TSC()
+            if (tsc) {
+               const auto ns = static_cast<double>(t) * ns_per_tick.load(::std::memory_order_relaxed);
+               return ::std::chrono::duration_cast<Duration>(::std::chrono::duration<double, ::std::nano>(ns));
+            }
+         #endif
+         return ::std::chrono::duration_cast<Duration>(::std::chrono::nanoseconds(t));
+      }
+   };
+
+} // namespace Langulus::Profiler
@@ -0,0 +1,240 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#include "Trace.hpp"
+
+
+namespace Langulus::Profiler::Trace
+{
+
+   namespace
+   {
+      ///                                                                     
+      /// Bounds-checked reader over bytes in memory                          
+      ///                                                                     
+      struct Cursor {
+         const uint8_t* at;
+         const uint8_t* end;
+         bool failed = false;
+
+         bool Done() const noexcept {
+            return failed or at == end;
+         }
+
+         uint8_t Byte() noexcept {
+            if (at == end) {
+               failed = true;
+               return 0;
+            }
+            return *at++;
+         }
+
+         uint64_t Varint() noexcept {
+            uint64_t v = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+               const auto b = Byte();
+               v |= uint64_t {b & 0x7Fu} << shift;
+               if (not (b & 0x80))
+                  return v;
+            }
+            failed = true;
+            return v;
+         }
+      };
+
+      ///                                                                     
+      /// Reader over a file stream, failing on a cut short file              
+      ///                                                                     
+      struct Stream {
+         ::std::istream& in;
+         bool failed = false;
+
+         uint8_t Byte() {
+            const auto c = in.get();
+            if (c == ::std::istream::traits_type::eof()) {
+               failed = true;
+               return 0;
+            }
+            return static_cast<uint8_t>(c);
+         }
+
+         uint64_t Varint() {
+            uint64_t v = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+               const auto b = Byte();
+               v |= uint64_t {b & 0x7Fu} << shift;
+               if (not (b & 0x80))
+                  return v;
+            }
+            failed = true;
+            return v;
+         }
+
+         bool Read(void* to, size_t size) {
+            in.read(static_cast<char*>(to), static_cast<::std::streamsize>(size));
+            failed |= static_cast<size_t>(in.gcount()) != size;
+            return not failed;
+         }
+
+         String Text() {
+            const auto size = Varint();
+            if (failed or size > MaxText) {
+               failed = true;
+               return {};
+            }
+            String s(size, '\0');
+            Read(s.data(), size);
+            return s;
+         }
+
+         // Sanity limits, so that corrupt sizes never allocate much    
+         static constexpr uint64_t MaxText = 1 << 16;
+         static constexpr uint64_t MaxChunk = 1 << 30;
+      };
+   }
+
+   /// Open a trace for streaming                                             
+   ///   @param file - the trace file                                         
+   ///   @return false if the file isn't a trace this version can read        
+   bool Reader::Open(const String& file) {
+      path = file;
+      in.open(path, ::std::ios::in | ::std::ios::binary);
+      if (not in.is_open()) {
+         Logger::Error("Can't open trace file: ", path);
+         return false;
+      }
+
+      Stream s {in};
+      char magic[sizeof(Magic)];
+      if (not s.Read(magic, sizeof(magic))
+      or ::std::memcmp(magic, Magic, sizeof(Magic))) {
+         Logger::Error("Not a profiler trace: ", path);
+         return false;
+      }
+
+      version = s.Varint();
+      if (s.failed or version != Version) {
+         Logger::Error("Unsupported trace version ", version, ": ", path);
+         return false;
+      }
+      return true;
+   }
+
+   /// Read records up to and including the next chunk of events              
+   /// A trace that was cut short is read up to its last complete record      
+   ///   @param thread - [out] the index of the thread the events are from    
+   ///   @param events - [out] the decoded events, replaced                   
+   ///   @return false when there are no more events                          
+   bool Reader::Next(size_t& thread, ::std::vector<Entry>& events) {
+      Stream s {in};
+      while (true) {
+         const auto record = in.get();
+         if (record == ::std::istream::traits_type::eof())
+            return false;
+
+         switch (static_cast<Record>(record)) {
+         case Record::Build: {
+            const auto id = s.Varint();
+            Build b;
+            b.properties = ::std::bitset<Build::Property::Counter> {s.Varint()};
+            b.bitness = s.Byte();
+            b.alignment = s.Byte();
+            b.endianness = s.Byte();
+            if (not s.failed)
+               builds.try_emplace(id, b);
+            break;
+         }
+         case Record::Descriptor: {
+            // Descriptors can't be moved, so fill one in place         
+            auto& d = descriptors.emplace_back();
+            d.id = static_cast<uint32_t>(s.Varint());
+            d.build = s.Varint();
+            d.line = static_cast<uint32_t>(s.Varint());
+            d.name = s.Text();
+            d.file = s.Text();
+            if (s.failed or d.id != descriptors.size() - 1) {
+               descriptors.pop_back();
+               s.failed = true;
+            }
+            break;
+         }
+         case Record::Clock: {
+            uint8_t bytes[8];
+            if (s.Read(bytes, sizeof(bytes))) {
+               uint64_t bits = 0;
+               for (unsigned i = 0; i < 8; ++i)
+                  bits |= uint64_t {bytes[i]} << (i * 8);
+               ::std::memcpy(&ns_per_tick, &bits, sizeof(bits));
+            }
+            break;
+         }
+         case Record::Events: {
+            thread = s.Varint();
+            if (thread & 1)
+               main_thread = thread >> 1;
+            thread >>= 1;
+            const auto size = s.Varint();
+            if (s.failed or size > Stream::MaxChunk) {
+               s.failed = true;
+               break;
+            }
+
+            chunk.resize(size);
+            if (not s.Read(chunk.data(), size))
+               break;
+
+            if (thread >= last.size())
+               last.resize(thread + 1, 0);
+
+            events.clear();
+            Cursor c {chunk.data(), chunk.data() + chunk.size()};
+            while (not c.Done()) {
+               const auto stamp = c.Varint();
+               last[thread] += stamp >> 1;
+               Entry e {Entry::NoDescriptor, last[thread]};
+               if (not (stamp & 1)) {
+                  const auto id = c.Varint();
+                  e.descriptor = static_cast<uint32_t>(id >> 1);
+                  if (id & 1)
+                     e.weight = static_cast<uint32_t>(c.Varint());
+               }
+               if (c.failed or (e.descriptor != Entry::NoDescriptor
+               and e.descriptor >= descriptors.size()))
+                  break;
+               events.push_back(e);
+            }
+            return true;
+         }
+         default:
+            s.failed = true;
+         }
+
+         if (s.failed) {
+            Logger::Warning("Trace is truncated or corrupt, read what was readable: ", path);
+            return false;
+         }
+      }
+   }
+
+   /// Load a whole trace in memory                                           
+   ///   @param file - the trace file                                         
+   ///   @return false if the file isn't a trace this version can read        
+   bool File::Load(const String& file) {
+      if (not Open(file))
+         return false;
+
+      size_t thread;
+      ::std::vector<Entry> events;
+      while (Next(thread, events)) {
+         if (thread >= threads.size())
+            threads.resize(thread + 1);
+         threads[thread].insert(threads[thread].end(), events.begin(), events.end());
+      }
+      return true;
+   }
+
+} // namespace Langulus::Profiler::Trace
@@ -0,0 +1,173 @@
+///                                                                           
+/// Langulus::Profiler                                                        
+/// Copyright (c) 2025 Dimo Markov <team@langulus.com>                        
+/// Part of the Langulus framework, see https://langulus.com                  
+///                                                                           
+/// SPDX-License-Identifier: MIT                                              
+///                                                                           
+#pragma once
+#include <Langulus/Profiler.hpp>
+#include <cstring>
+#include <fstream>
+
+#if not LANGULUS_FEATURE(PROFILING)
+   #error This file shouldn't be included if LANGULUS_FEATURE_PROFILING is disabled
+#endif
+
+///                                                                           
+/// The binary trace format                                                   
+///                                                                           
+/// A trace starts with the Magic signature and a varint Version, followed by 
+/// records, each starting with a Record byte. Records are streamed in        
+/// chunks, and every chunk is self-contained, so a trace that was cut short  
+/// is still readable up to its last complete chunk:                          
+///                                                                           
+///   Build       varint id, varint properties, bitness, alignment,           
+///               endianness bytes                                            
+///   Descriptor  varint id, varint build id, varint line, then name and      
+///               file, each as varint length followed by the characters      
+///   Clock       the timer's nanoseconds per tick, as a little-endian        
+///               IEEE double, the last one in the file is the most precise   
+///   Events      varint (thread index << 1 | main thread flag), varint byte  
+///               count, and that many bytes of events, which are either a    
+///               varint (delta << 1) followed by a varint (descriptor id << 1
+///               | sampled) for a scope begin, or a varint (delta << 1 | 1)  
+///               for a scope end. Deltas are in ticks since the previous     
+///               event on the same thread, across chunks. A sampled begin is 
+///               followed by a varint of how many entries it stands for      
+///                                                                           
+namespace Langulus::Profiler::Trace
+{
+
+   constexpr char     Magic[4] = {'L', 'G', 'P', 'T'};
+   constexpr uint64_t Version = 1;
+
+   enum class Record : uint8_t {
+      Build = 1,
+      Descriptor,
+      Clock,
+      Events
+   };
+
+   using Bytes = ::std::vector<uint8_t>;
+
+   /// Append an unsigned LEB128 varint                                       
+   ///   @param out - the buffer to append to                                 
+   ///   @param v - the value to encode                                       
+   LANGULUS(ALWAYS_INLINED)
+   void PutVarint(Bytes& out, uint64_t v) {
+      while (v >= 0x80) {
+         out.push_back(static_cast<uint8_t>(v) | 0x80);
+         v >>= 7;
+      }
+      out.push_back(static_cast<uint8_t>(v));
+   }
+
+   /// Append a length-prefixed string                                        
+   ///   @param out - the buffer to append to                                 
+   ///   @param s - the string to encode                                      
+   inline void PutString(Bytes& out, const String& s) {
+      PutVarint(out, s.size());
+      out.insert(out.end(), s.begin(), s.end());
+   }
+
+   /// Append a timestamp, as a delta to the previous one on the thread       
+   ///   @param out - the buffer to append to                                 
+   ///   @param last - the previous timestamp, gets updated                   
+   ///   @param now - the timestamp to encode                                 
+   ///   @param end - whether it's a scope end                                
+   LANGULUS(ALWAYS_INLINED)
+   void PutStamp(Bytes& out, Ticks& last, Ticks now, bool end) {
+      // Timestamps read on different cores may step back slightly      
+      const Ticks delta = now > last ? now - last : 0;
+      if (now > last)
+         last = now;
+      PutVarint(out, (delta << 1) | (end ? 1 : 0));
+   }
+
+   /// Append a scope begin event                                             
+   ///   @param out - the buffer to append to                                 
+   ///   @param last - the thread's previous timestamp, gets updated          
+   ///   @param now - the timestamp of the event                              
+   ///   @param descriptor - the id of the measurement site                   
+   ///   @param weight - how many entries the scope stands for, if sampled    
+   LANGULUS(ALWAYS_INLINED)
+   void PutBegin(Bytes& out, Ticks& last, Ticks now, uint32_t descriptor, uint32_t weight) {
+      PutStamp(out, last, now, false);
+      if (weight == 1)
+         PutVarint(out, uint64_t {descriptor} << 1);
+      else {
+         PutVarint(out, (uint64_t {descriptor} << 1) | 1);
+         PutVarint(out, weight);
+      }
+   }
+
+   /// Append a scope end event                                               
+   ///   @param out - the buffer to append to                                 
+   ///   @param last - the thread's previous timestamp, gets updated          
+   ///   @param now - the timestamp of the event                              
+   LANGULUS(ALWAYS_INLINED)
+   void PutEnd(Bytes& out, Ticks& last, Ticks now) {
+      PutStamp(out, last, now, true);
+   }
+
+
+   ///                                                                        
+   /// A decoded event                                                        
+   ///                                                                        
+   struct Entry {
+      // Descriptor id, or NoDescriptor for a scope end                 
+      uint32_t descriptor;
+      Ticks    timestamp;
+      uint32_t weight = 1;
+
+      static constexpr uint32_t NoDescriptor = ~uint32_t {0};
+   };
+
+
+   ///                                                                        
+   /// A trace reader, streaming one chunk of events at a time, so that       
+   /// traces of any size are read with bounded memory. Builds, descriptors   
+   /// and the clock rate are collected as they're encountered, and are       
+   /// always known before the events that reference them                     
+   ///                                                                        
+   struct Reader {
+      ::std::unordered_map<BuildID, Build> builds;
+      ::std::deque<Descriptor> descriptors;
+      double ns_per_tick = 1.0;
+      uint64_t version = 0;
+
+      // Index of the thread that ran main(), if it recorded anything   
+      static constexpr size_t NoThread = ~size_t {0};
+      size_t main_thread = NoThread;
+
+   private:
+      ::std::ifstream in;
+      String path;
+      ::std::vector<Ticks> last;
+      Bytes chunk;
+
+   public:
+      LANGULUS_API(PROFILER) bool Open(const String&);
+      LANGULUS_API(PROFILER) bool Next(size_t& thread, ::std::vector<Entry>&);
+
+      /// Convert a difference between timestamps to time                     
+      ///   @param t - the raw duration                                       
+      ///   @return the duration                                              
+      Time ToTime(Ticks t) const noexcept {
+         return ::std::chrono::duration_cast<Time>(
+            ::std::chrono::duration<double, ::std::nano>(t * ns_per_tick));
+      }
+   };
+
+
+   ///                                                                        
+   /// A trace, loaded in memory for offline conversion                       
+   ///                                                                        
+   struct File : Reader {
+      ::std::vector<::std::vector<Entry>> threads;
+
+      LANGULUS_API(PROFILER) bool Load(const String&);
+   };
+
+} // namespace Langulus::Profiler::Trace